@@ -0,0 +1,199 @@
+#include "../../build/include/cce.h"
+#include <stdio.h>
+#include <GL/gl.h>
+#include <unistd.h>
+
+// Builds a picture from the raster primitives, a flood fill and a noise field, committing an
+// undo step after each edit. Checks the shapes landed, that history is refused while a pixel
+// span is locked, and that undo/redo walk back to exactly the recorded states.
+// Then replays the history on screen. Exits non-zero on any failed check.
+
+#define STEPS 6
+
+static int same_color(CCE_Color a, CCE_Color b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+static CCE_Color pixel_at(CCE_Layer* layer, int x, int y)
+{
+    // Snapshots share the layer's pixels, so one is a cheap read-only view.
+    CCE_LayerSnapshot* view = cce_layer_snapshot(layer);
+    CCE_Color color = cce_layer_snapshot_get_pixel(view, x, y);
+    cce_layer_snapshot_free(view);
+    return color;
+}
+
+// Pixels on a 3 px grid where the layer differs from `expected`.
+static long count_diff(CCE_Layer* layer, const CCE_LayerSnapshot* expected)
+{
+    CCE_LayerSnapshot* now = cce_layer_snapshot(layer);
+    long bad = 0;
+    for (int y = 0; y < layer->scr_h; y += 3) {
+        for (int x = 0; x < layer->scr_w; x += 3) {
+            if (!same_color(cce_layer_snapshot_get_pixel(now, x, y), cce_layer_snapshot_get_pixel(expected, x, y))) bad++;
+        }
+    }
+    cce_layer_snapshot_free(now);
+    return bad;
+}
+
+static int check(int ok, const char* what)
+{
+    printf("  %-44s %s\n", what, ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+int main() {
+    int width = 1280;
+    int height = 720;
+
+    printf("=== CCE Undo / Raster Test ===\n");
+
+    set_engine_seed(1337);
+
+    if (cce_engine_init() != 0) {
+        printf("Engine init failed\n");
+        return -1;
+    }
+
+    Window* window = cce_window_create(width, height,
+        CCE_NAME " " CCE_VERSION " | " "Undo / Raster");
+
+    if (!window) {
+        printf("Window creation failed\n");
+        cce_engine_cleanup();
+        return -1;
+    }
+
+    cce_setup_2d_projection(width, height);
+
+    CCE_FPS_Timer* timer = cce_fps_timer_create(60.0);
+
+    CCE_Layer* canvas = cce_layer_cpu_create(width, height, "Canvas");
+
+    const CCE_Color background = { 24, 24, 32, 255 };
+    const CCE_Color white = { 255, 255, 255, 255 };
+    const CCE_Color red = { 220, 40, 40, 255 };
+    const CCE_Color gold = { 240, 190, 40, 255 };
+
+    cce_set_pixel_rect(canvas, 0, 0, width - 1, height - 1, background);
+    CCE_UndoHistory* history = cce_undo_create(canvas, STEPS + 2);
+    CCE_LayerSnapshot* states[STEPS + 1] = { 0 };
+    states[0] = cce_layer_snapshot(canvas);
+
+    int failed = 0;
+    printf("Edits:\n");
+    for (int step = 1; step <= STEPS; step++) {
+        switch (step) {
+            case 1: {
+                const CCE_Point star[] = {
+                    { 640, 60 }, { 680, 180 }, { 800, 180 }, { 700, 250 }, { 740, 370 },
+                    { 640, 300 }, { 540, 370 }, { 580, 250 }, { 480, 180 }, { 600, 180 },
+                };
+                cce_fill_polygon(canvas, star, 10, gold);
+                failed += check(same_color(pixel_at(canvas, 640, 220), gold), "polygon covers its centre");
+            } break;
+            case 2:
+                // Ring, then a bucket fill from inside it.
+                cce_draw_circle(canvas, 250, 250, 120, white);
+                cce_layer_flood_fill(canvas, 250, 250, red, 0);
+                failed += check(same_color(pixel_at(canvas, 250, 250), red) &&
+                                same_color(pixel_at(canvas, 250 + 119, 250), red), "flood fill stays inside the ring");
+                failed += check(same_color(pixel_at(canvas, 250 + 120, 250), white) &&
+                                same_color(pixel_at(canvas, 250 + 125, 250), background), "ring and outside untouched");
+                break;
+            case 3:
+                cce_fill_ellipse(canvas, 1000, 200, 180, 90, (CCE_Color){ 60, 160, 90, 255 });
+                cce_draw_ellipse(canvas, 1000, 200, 200, 110, white);
+                failed += check(same_color(pixel_at(canvas, 1000 + 180, 200), (CCE_Color){ 60, 160, 90, 255 }) &&
+                                same_color(pixel_at(canvas, 1000 + 200, 200), white), "ellipse fill and outline");
+                break;
+            case 4:
+                // Far off-screen endpoints and radii are clipped before any pixel is walked.
+                cce_draw_line(canvas, -100000000, 650, 100000000, 650, white);
+                cce_draw_line_thick(canvas, 40, 700, 1240, 420, 5.0f, (CCE_Color){ 90, 140, 255, 255 });
+                cce_draw_circle(canvas, 640, 100000 + 700, 100000, gold);
+                failed += check(same_color(pixel_at(canvas, 0, 650), white) &&
+                                same_color(pixel_at(canvas, width - 1, 650), white), "huge line spans the whole row");
+                failed += check(same_color(pixel_at(canvas, 640, 700), gold), "huge circle touches the bottom");
+                break;
+            case 5: {
+                CCE_Noise noise = cce_noise_make(CCE_NOISE_VALUE, CCE_NOISE_FBM, R2);
+                CCE_NoiseField* field = cce_noise_field_create(&noise, 0, 0, 360, 180);
+                failed += check(field && cce_fill_noise_field(canvas, 880, 400, field, DefaultGrass) == 0, "noise field drawn");
+                failed += check(!same_color(pixel_at(canvas, 1000, 500), background), "noise field covers its rect");
+                cce_noise_field_free(field);
+            } break;
+            default: {
+                // History must not capture pixels a locked span is still writing.
+                CCE_PixelSpan span;
+                cce_layer_lock_rect(canvas, 100, 500, 200, 100, &span);
+                failed += check(cce_undo_commit(history) == -1, "commit refused while locked");
+                for (int i = 0; i < span.count; i++) {
+                    CCE_PixelRegion* r = &span.regions[i];
+                    for (int y = 0; y < r->h; y++) {
+                        for (int x = 0; x < r->w; x++) r->pixels[y * r->stride + x] = (CCE_Color){ 200, 100, 200, 255 };
+                    }
+                }
+                cce_layer_unlock(canvas, &span);
+            } break;
+        }
+        failed += check(cce_undo_commit(history) == 0, "commit");
+        states[step] = cce_layer_snapshot(canvas);
+    }
+    printf("History holds %zu KB of pixels\n", cce_undo_get_memory(history) / 1024);
+
+    printf("Undo / redo:\n");
+    long bad = 0;
+    for (int step = STEPS - 1; step >= 0; step--) {
+        if (cce_undo(history) != 0) bad++;
+        bad += count_diff(canvas, states[step]);
+    }
+    failed += check(bad == 0 && cce_undo(history) == -1, "undo restores every recorded state");
+    bad = 0;
+    for (int step = 1; step <= STEPS; step++) {
+        if (cce_redo(history) != 0) bad++;
+        bad += count_diff(canvas, states[step]);
+    }
+    failed += check(bad == 0 && cce_redo(history) == -1, "redo restores every recorded state");
+
+    // Replay: step back and forth through the history twice a second.
+    int frame = 0;
+    int position = STEPS, direction = -1;
+
+    while (cce_window_should_close(window) == 0 && frame < 600)
+    {
+        if (cce_fps_timer_should_update(timer))
+        {
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            if (frame % 30 == 29) {
+                if (position == 0) direction = 1;
+                if (position == STEPS) direction = -1;
+                if (direction < 0) cce_undo(history);
+                else cce_redo(history);
+                position += direction;
+            }
+
+            CCE_Layer* layers[] = {canvas};
+            render_pie(layers, 1);
+
+            cce_window_swap_buffers(window);
+            cce_window_poll_events();
+            frame++;
+        }
+        usleep(100);
+    }
+
+    for (int step = 0; step <= STEPS; step++) cce_layer_snapshot_free(states[step]);
+    cce_undo_destroy(history);
+    cce_layer_destroy(canvas);
+    cce_fps_timer_destroy(timer);
+    cce_window_destroy(window);
+    cce_engine_cleanup();
+
+    printf(failed ? "FAILED\n" : "OK\n");
+    return failed ? 1 : 0;
+}
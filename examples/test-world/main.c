@@ -0,0 +1,155 @@
+#include "../../build/include/cce.h"
+#include <stdio.h>
+#include <GL/gl.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+// Paints a 4096x2048 noise terrain into a world canvas, scrolls the camera across it under a
+// tight memory budget (so off-screen chunks get compressed and spilled), then reads every
+// sampled pixel back and checks it against the terrain. Exits non-zero on any mismatch.
+
+#define WORLD_X0 -2048
+#define WORLD_Y0 -1024
+#define WORLD_W 4096
+#define WORLD_H 2048
+
+// Chunk-aligned lake: every chunk under it becomes a single uniform colour.
+#define LAKE_X0 0
+#define LAKE_Y0 0
+#define LAKE_X1 1023
+#define LAKE_Y1 511
+
+static CCE_Color terrain_color(float value)
+{
+    // Eight flat bands compress well when chunks go idle.
+    int band = (int)(value * 8.0f);
+    if (band < 0) band = 0;
+    if (band > 7) band = 7;
+    return (CCE_Color){ (pct)(band * 24), (pct)(80 + band * 20), (pct)(40 + band * 8), 255 };
+}
+
+static CCE_Color expected_color(const CCE_Noise* noise, int x, int y)
+{
+    const CCE_Color lake = { 30, 60, 160, 255 };
+    if (x >= LAKE_X0 && x <= LAKE_X1 && y >= LAKE_Y0 && y <= LAKE_Y1) return lake;
+    if (x < WORLD_X0 || x >= WORLD_X0 + WORLD_W || y < WORLD_Y0 || y >= WORLD_Y0 + WORLD_H) {
+        return (CCE_Color){ 0, 0, 0, 0 };
+    }
+    return terrain_color(cce_noise_sample(noise, (float)x, (float)y));
+}
+
+static int same_color(CCE_Color a, CCE_Color b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+int main() {
+    int width = 1280;
+    int height = 720;
+
+    printf("=== CCE World Canvas Test ===\n");
+
+    set_engine_seed(1337);
+
+    if (cce_engine_init() != 0) {
+        printf("Engine init failed\n");
+        return -1;
+    }
+
+    Window* window = cce_window_create(width, height,
+        CCE_NAME " " CCE_VERSION " | " "World Canvas");
+
+    if (!window) {
+        printf("Window creation failed\n");
+        cce_engine_cleanup();
+        return -1;
+    }
+
+    cce_setup_2d_projection(width, height);
+
+    CCE_FPS_Timer* timer = cce_fps_timer_create(60.0);
+
+    CCE_WorldLayer* world = cce_world_create(width, height, "World", 128);
+    if (!world) {
+        printf("World creation failed\n");
+        cce_window_destroy(window);
+        cce_engine_cleanup();
+        return -1;
+    }
+
+    // 4 MB for raw and compressed chunks in RAM is less than one screen of raw tiles, so idle
+    // chunks are compressed and then spilled; the painted terrain alone is 32 MB raw.
+    cce_world_set_residency(world, (size_t)4 * 1024 * 1024, 30);
+
+    CCE_Noise noise = cce_noise_make(CCE_NOISE_PERLIN, CCE_NOISE_FBM, R1);
+    float* row = malloc(WORLD_W * sizeof(float));
+    if (!row) {
+        printf("Allocation failed\n");
+        return -1;
+    }
+    for (int y = 0; y < WORLD_H; y++) {
+        cce_noise_fill(&noise, row, WORLD_W, WORLD_X0, WORLD_Y0 + y, WORLD_W, 1);
+        for (int x = 0; x < WORLD_W; x++) {
+            cce_world_set_pixel(world, WORLD_X0 + x, WORLD_Y0 + y, terrain_color(row[x]));
+        }
+    }
+    free(row);
+    cce_world_set_pixel_rect(world, LAKE_X0, LAKE_Y0, LAKE_X1, LAKE_Y1, (CCE_Color){ 30, 60, 160, 255 });
+
+    CCE_WorldMemory memory;
+    int max_packed = 0, max_spilled = 0;
+    int frame = 0;
+
+    while (cce_window_should_close(window) == 0 && frame < 600)
+    {
+        if (cce_fps_timer_should_update(timer))
+        {
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            // Sweep the camera across the terrain, wrapping at the far edges.
+            int camera_x = WORLD_X0 + (frame * 17) % (WORLD_W - width);
+            int camera_y = WORLD_Y0 + (frame * 5) % (WORLD_H - height);
+            cce_world_set_camera(world, camera_x, camera_y);
+            render_world(world);
+
+            cce_world_get_memory(world, &memory);
+            if (memory.packed_chunks > max_packed) max_packed = memory.packed_chunks;
+            if (memory.spilled_chunks > max_spilled) max_spilled = memory.spilled_chunks;
+
+            cce_window_swap_buffers(window);
+            cce_window_poll_events();
+
+            frame++;
+            if (frame % 100 == 0) {
+                printf("Frame: %d | raw %d, packed %d, spilled %d chunks\n",
+                    frame, memory.raw_chunks, memory.packed_chunks, memory.spilled_chunks);
+            }
+        }
+        usleep(100);
+    }
+
+    // Reading back brings packed and spilled chunks to raw pixels again.
+    long checked = 0, bad = 0;
+    for (int y = WORLD_Y0 - 64; y < WORLD_Y0 + WORLD_H + 64; y += 7) {
+        for (int x = WORLD_X0 - 64; x < WORLD_X0 + WORLD_W + 64; x += 7) {
+            if (!same_color(cce_world_get_pixel(world, x, y), expected_color(&noise, x, y))) bad++;
+            checked++;
+        }
+    }
+    printf("Checked %ld pixels, %ld wrong | peak packed %d, spilled %d chunks\n", checked, bad, max_packed, max_spilled);
+
+    int failed = bad != 0;
+    if (frame >= 600 && (max_packed == 0 || max_spilled == 0)) {
+        printf("Residency budget never compressed or spilled a chunk\n");
+        failed = 1;
+    }
+
+    cce_world_destroy(world);
+    cce_fps_timer_destroy(timer);
+    cce_window_destroy(window);
+    cce_engine_cleanup();
+
+    printf(failed ? "FAILED\n" : "OK\n");
+    return failed ? 1 : 0;
+}
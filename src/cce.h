@@ -31,6 +31,9 @@ SOFTWARE.
 #define CCE_VERNAME "Embryo"
 #define CCE_NAME    "CastleCore Engine"
 
+#include <stddef.h>
+#include <stdint.h>
+
 /* GLFW */
 
 typedef struct Window Window;
@@ -80,8 +83,14 @@ int cce_get_version(char ** ver_str_ptr);
 void set_engine_seed(long new_engine_seed);
 long get_engine_seed(void);
 void set_engine_msaa(int factor);
+// Worker threads for parallel CPU layer drawing (0 = one per core). Takes effect before the first parallel call.
+void set_engine_threads(int count);
+// Default chunk size for new CPU layers (16..1024, CHUNK_SIZE unless changed); see cce_calibrate_chunk_size.
+void set_engine_chunk_size(int size);
 int get_engine_chunk_size(void);
 int get_randpack_value(RandPackIndex index);
+// Pixel kernel set picked at init: "avx2", "sse2", "neon" or "scalar".
+const char* cce_get_kernel_isa(void);
 
 /*
     W I N D O W
@@ -194,15 +203,61 @@ int cce_draw_triangles_textured(
     CCE_Color tint
 );
 
+// Per-instance record for cce_draw_sprites_instanced (36 bytes vs 6 x (x,y,u,v) vertices per quad).
+// (x,y) is the bottom-left corner in screen space, same as cce_draw_texture_region.
 typedef struct
+{
+    float x, y;
+    float w, h;
+    float u0, v0;
+    float u1, v1;
+    CCE_Color tint;
+} CCE_SpriteInstance;
+
+// Draws `count` sprites from one texture with a single instanced draw over a static unit quad.
+int cce_draw_sprites_instanced(const CCE_Texture* texture, const CCE_SpriteInstance* instances, int count);
+
+// Quad batching for cce_draw_texture_region / cce_draw_triangles_textured (and GPU text / sprites).
+// Quads are collected into one streaming vertex buffer and submitted when the texture, tint
+// or render target changes. Inside cce_layer_begin/end or cce_batch_begin/end submission is
+// deferred; outside, every draw is submitted before returning.
+int cce_batch_begin(void);
+int cce_batch_flush(void);
+int cce_batch_end(void);
+// Bytes of vertex/instance data streamed to the GPU during the last completed frame.
+size_t cce_batch_get_streamed_bytes(void);
+
+typedef struct CCE_Chunk
 {
     int x, y;
     int w, h;
-    CCE_Color* data;
+    CCE_Color* data;    // NULL while the chunk is uniform and holds no pixel memory
     bool dirty;
     bool visible;
+    // Uniform chunks read as `fill` everywhere; `data` may keep stale storage for reuse.
+    bool uniform;
+    CCE_Color fill;
+    // Changed area (chunk-local, inclusive), valid while `dirty` is set; only this is uploaded.
+    int dirty_x0, dirty_y0;
+    int dirty_x1, dirty_y1;
+    // Next chunk in the owning layer's dirty queue (intrusive, valid while `dirty` is set).
+    struct CCE_Chunk* dirty_next;
+    // Content hash of what the GPU holds for this chunk (valid only with upload hashing on).
+    uint64_t upload_hash;
+    bool upload_hash_valid;
+    // Snapshot storage still backed by `data`; the next write copies it out first.
+    struct CCE_ChunkBuffer* shared;
 } CCE_Chunk;
 
+// Cumulative texture upload counters of a CPU layer.
+typedef struct
+{
+    size_t uploaded_bytes;
+    size_t skipped_bytes;   // dirty bytes not sent because the chunk hash was unchanged
+    long uploaded_chunks;
+    long skipped_chunks;
+} CCE_UploadStats;
+
 typedef enum
 {
     CCE_LAYER_CPU = 0,
@@ -218,6 +273,15 @@ typedef enum
     CCE_LAYER_SHADER_BAKE_ON_DIRTY = 2,
 } CCE_LayerShaderMode;
 
+// How CPU layer writes combine with the pixels already there. Straight (non-premultiplied) alpha.
+typedef enum
+{
+    CCE_BLEND_REPLACE = 0,  // overwrite (default)
+    CCE_BLEND_ALPHA = 1,    // source-over
+    CCE_BLEND_ADD = 2,      // dst + src * a, saturating
+    CCE_BLEND_MULTIPLY = 3, // dst * src, faded by a
+} CCE_BlendMode;
+
 struct CCE_Layer
 {
     int scr_w, scr_h;
@@ -234,12 +298,21 @@ struct CCE_Layer
 
     // === CPU backend data (legacy / software layer) ===
     int chunk_size;
+    int chunk_shift;      // log2(chunk_size) when it is a power of two, otherwise 0
     int chunk_count_x, chunk_count_y;
-    CCE_Chunk*** chunks;
-    bool has_dirty; // fast-path: if false, skip scanning chunks for updates
-    unsigned int pbo_ids[2];
-    int current_pbo_index;
-    int pbo_size;
+    CCE_Chunk* chunks;    // chunk_count_x * chunk_count_y headers, row-major (start of the chunk arena)
+    CCE_Color* pixels;    // pixel slots of all chunks inside the same arena, page aligned
+    size_t chunk_stride;  // pixels per chunk slot in `pixels`
+    size_t arena_bytes;   // reserved size; slots only become resident when written
+    bool has_dirty; // fast-path: if false, nothing is queued for upload
+    // Chunks waiting for upload, in the order they first became dirty.
+    CCE_Chunk* dirty_head;
+    CCE_Chunk* dirty_tail;
+    int dirty_count;
+    bool hash_uploads;    // compare chunk hashes before uploading (off by default)
+    CCE_UploadStats upload_stats;
+    CCE_BlendMode blend_mode; // applied by cce_set_pixel*, CPU text and sprites
+    int lock_count;       // spans from cce_layer_lock_rect not yet unlocked
 
     // === GPU backend data (render-target layer) ===
     unsigned int fbo; // framebuffer that renders into `texture`
@@ -279,11 +352,62 @@ CCE_Color cce_get_color(int pos_x, int pos_y, int offset_x, int offset_y, CCE_Pa
 void cce_set_pixel(CCE_Layer* layer, int screen_x, int screen_y, CCE_Color color);
 void cce_set_pixel_rect(CCE_Layer* layer, int x0, int y0, int x1, int y1, CCE_Color color);
 
+// Direct pixel access for CPU layers.
+// A locked rect is split at chunk borders; each region is written through its own row pointer.
+typedef struct
+{
+    int x, y;           // screen position of pixels[0]
+    int w, h;
+    CCE_Color* pixels;  // row r starts at pixels + r * stride
+    int stride;         // in pixels
+} CCE_PixelRegion;
+
+typedef struct
+{
+    int x, y, w, h;     // locked rect after clipping to the layer
+    int count;
+    CCE_PixelRegion* regions;
+} CCE_PixelSpan;
+
+// Locks [x, x+w) x [y, y+h), clipped to the layer. Returns 0 on success (count may be 0), -1 on error.
+// While any span is locked the layer cannot be snapshotted or restored (see cce_layer_snapshot).
+int cce_layer_lock_rect(CCE_Layer* layer, int x, int y, int w, int h, CCE_PixelSpan* out);
+// Marks every locked region dirty and releases the span.
+void cce_layer_unlock(CCE_Layer* layer, CCE_PixelSpan* span);
+
+// Parallel CPU layer drawing: work is split per chunk and spread over the worker pool.
+// Calls return once every chunk is written; texture upload stays on the GL thread.
+// `fn` may run on any worker and must only touch `chunk`; return non-zero if it changed pixels.
+typedef int (*CCE_ChunkFn)(CCE_Layer* layer, CCE_Chunk* chunk, void* userdata);
+int cce_layer_parallel_for_chunks(CCE_Layer* layer, CCE_ChunkFn fn, void* userdata);
+void cce_set_pixel_rect_parallel(CCE_Layer* layer, int x0, int y0, int x1, int y1, CCE_Color color);
+// Fills [x0..x1]x[y0..y1] with cell_size squares anchored at (x0, y0);
+// each cell takes cce_get_color(cell_x, cell_y, offset_x, offset_y, palette, ...).
+void cce_fill_palette_rect(CCE_Layer* layer, int x0, int y0, int x1, int y1, int cell_size,
+                           int offset_x, int offset_y, CCE_Palette palette, ...);
+
+// Scattered single-pixel writes (particles, simulations). Writes are bucketed by chunk and applied
+// chunk by chunk in submission order with one dirty mark per chunk; writes outside the layer are dropped.
+typedef struct
+{
+    int x, y;
+    CCE_Color color;
+} CCE_PixelWrite;
+
+void cce_set_pixels(CCE_Layer* layer, const CCE_PixelWrite* writes, size_t count);
+// Same, with the touched chunks spread over the worker pool for large batches.
+void cce_set_pixels_parallel(CCE_Layer* layer, const CCE_PixelWrite* writes, size_t count);
+
 // Layer creation
 // `cce_layer_create` now creates a GPU render-target layer by default (baked drawing; minimal CPU per frame).
 // Use `cce_layer_cpu_create` for the legacy chunk-based CPU layer.
 CCE_Layer* cce_layer_create(int screen_w, int screen_h, char * name, CCE_LayerBackend backend);
 CCE_Layer* cce_layer_cpu_create(int screen_w, int screen_h, char * name);
+// Same, with an explicit chunk size in pixels (0 = engine default). Powers of two address chunks by shift/mask.
+CCE_Layer* cce_layer_cpu_create_ex(int screen_w, int screen_h, char * name, int chunk_size);
+// Times pixel writes plus uploads for a few candidate chunk sizes on a w x h layer and returns
+// the fastest one. Needs a current GL context; pass the result to set_engine_chunk_size.
+int cce_calibrate_chunk_size(int screen_w, int screen_h);
 CCE_Layer* cce_layer_gpu_create(int screen_w, int screen_h, char * name);
 
 // GPU layer recording helpers.
@@ -292,6 +416,14 @@ int cce_layer_begin(CCE_Layer* layer);
 int cce_layer_end(CCE_Layer* layer);
 int cce_layer_clear(CCE_Layer* layer, CCE_Color color);
 
+// Blend mode for later CPU writes to the layer.
+int cce_layer_set_blend_mode(CCE_Layer* layer, CCE_BlendMode mode);
+
+// Upload suppression: with hashing on, a dirty chunk whose contents hash the same as its last
+// upload (e.g. a shape erased and redrawn in place) is not sent again.
+int cce_layer_set_upload_hashing(CCE_Layer* layer, bool enabled);
+int cce_layer_get_upload_stats(const CCE_Layer* layer, CCE_UploadStats* out);
+
 // Per-layer shader (applied to the layer's texture).
 int cce_layer_set_shader(CCE_Layer* layer, const CCE_Shader* shader, CCE_LayerShaderMode mode, float coefficient);
 int cce_layer_set_shader_tint(CCE_Layer* layer, CCE_Color tint);
@@ -300,6 +432,222 @@ void render_layer(CCE_Layer* layer);
 void cce_layer_destroy(CCE_Layer* layer);
 void render_pie(CCE_Layer** layers, int count); // This is a rendering of several layers one after the other.
 
+/*
+    R A S T E R
+*/
+
+// CPU layer primitives. Shapes are scan-converted into horizontal spans and written chunk by chunk
+// with the fill kernels and the layer blend mode; each pixel is written once, so translucent shapes
+// blend evenly. GPU layers draw one rect per span. Return 0, or -1 on bad arguments.
+typedef struct
+{
+    int x, y;
+} CCE_Point;
+
+int cce_draw_line(CCE_Layer* layer, int x0, int y0, int x1, int y1, CCE_Color color);
+// Thickness is measured across the line; the ends reach half a pixel past both endpoints.
+int cce_draw_line_thick(CCE_Layer* layer, int x0, int y0, int x1, int y1, float thickness, CCE_Color color);
+int cce_draw_circle(CCE_Layer* layer, int cx, int cy, int radius, CCE_Color color);
+int cce_fill_circle(CCE_Layer* layer, int cx, int cy, int radius, CCE_Color color);
+int cce_draw_ellipse(CCE_Layer* layer, int cx, int cy, int rx, int ry, CCE_Color color);
+int cce_fill_ellipse(CCE_Layer* layer, int cx, int cy, int rx, int ry, CCE_Color color);
+// Vertices sit on pixel corners: (0,0) (4,0) (4,4) (0,4) covers 4x4 pixels. Concave and
+// self-intersecting outlines fill by the even-odd rule.
+int cce_fill_polygon(CCE_Layer* layer, const CCE_Point* points, int count, CCE_Color color);
+// Bucket fill of the 4-connected region around (x, y) whose pixels differ from the seed pixel
+// by at most `tolerance` (0..255) in every channel. CPU layers only.
+int cce_layer_flood_fill(CCE_Layer* layer, int x, int y, CCE_Color color, int tolerance);
+
+/*
+    H I S T O R Y
+*/
+
+// CPU layer snapshots. Taking one copies no pixels: the snapshot shares each chunk's storage,
+// and a chunk is copied out only when the layer first writes to it afterwards, so a snapshot
+// costs memory in proportion to what changed since it was taken.
+typedef struct CCE_LayerSnapshot CCE_LayerSnapshot;
+
+// Snapshot, restore, undo and redo fail while the layer has a locked pixel span: the span's
+// pixels would be shared with the snapshot, and later writes through it would change both.
+CCE_LayerSnapshot* cce_layer_snapshot(CCE_Layer* layer);
+// Puts `layer` (the snapshot's own layer) back as it was; only chunks that differ are re-uploaded.
+int cce_layer_restore(CCE_Layer* layer, const CCE_LayerSnapshot* snapshot);
+CCE_Color cce_layer_snapshot_get_pixel(const CCE_LayerSnapshot* snapshot, int x, int y);
+void cce_layer_snapshot_free(CCE_LayerSnapshot* snapshot);
+
+// Bounded undo history built on snapshots. The layer state at creation is the first entry;
+// call cce_undo_commit after each finished edit. Steps past `depth` drop the oldest state.
+typedef struct CCE_UndoHistory CCE_UndoHistory;
+
+CCE_UndoHistory* cce_undo_create(CCE_Layer* layer, int depth);
+int cce_undo_commit(CCE_UndoHistory* history);
+// Return 0, or -1 when there is nothing to undo / redo.
+int cce_undo(CCE_UndoHistory* history);
+int cce_redo(CCE_UndoHistory* history);
+// Bytes of pixels held by the history alone (storage shared between states counts once).
+size_t cce_undo_get_memory(const CCE_UndoHistory* history);
+void cce_undo_destroy(CCE_UndoHistory* history);
+
+/*
+    N O I S E
+*/
+
+// Coherent 2D noise: value or Perlin (gradient) lattice noise summed over octaves.
+// Results are in [0, 1] and identical on every kernel ISA for the same parameters.
+typedef enum CCE_NoiseType
+{
+    CCE_NOISE_VALUE = 0,
+    CCE_NOISE_PERLIN = 1,
+} CCE_NoiseType;
+
+typedef enum CCE_NoiseFractal
+{
+    CCE_NOISE_FBM = 0,      // sum of octaves
+    CCE_NOISE_RIDGED = 1,   // sum of (1 - |octave|)^2: sharp crests
+} CCE_NoiseFractal;
+
+typedef struct CCE_Noise
+{
+    CCE_NoiseType type;
+    CCE_NoiseFractal fractal;
+    uint32_t seed;
+    float frequency;    // lattice cells per pixel in the first octave
+    int octaves;        // 1..CCE_NOISE_MAX_OCTAVES
+    float lacunarity;   // frequency factor between octaves
+    float gain;         // amplitude factor between octaves
+} CCE_Noise;
+
+#define CCE_NOISE_MAX_OCTAVES 16
+
+// 4 octaves at 1/64 px, lacunarity 2, gain 0.5, seeded from the engine seed and one RandPack value.
+CCE_Noise cce_noise_make(CCE_NoiseType type, CCE_NoiseFractal fractal, RandPackIndex slot);
+float cce_noise_sample(const CCE_Noise* noise, float x, float y);
+// Fills out[row * stride + col] with the noise at pixel (x + col, y + row) for a w x h rect.
+// Large rects are split into chunk-high bands and spread over the worker pool.
+int cce_noise_fill(const CCE_Noise* noise, float* out, int stride, int x, int y, int w, int h);
+
+// A noise rect evaluated once and kept, so redraws only map cached values.
+typedef struct CCE_NoiseField
+{
+    int x, y;           // noise-space pixel of values[0]
+    int w, h;
+    float* values;      // w * h, row-major
+} CCE_NoiseField;
+
+CCE_NoiseField* cce_noise_field_create(const CCE_Noise* noise, int x, int y, int w, int h);
+void cce_noise_field_free(CCE_NoiseField* field);
+// Draws `field` with its top-left at (x, y), each value v taking the noise palette colour of
+// v * 255 (DefaultGrass, DefaultStone and DefaultCloud only). Returns 0, or -1 on bad arguments.
+int cce_fill_noise_field(CCE_Layer* layer, int x, int y, const CCE_NoiseField* field, CCE_Palette palette);
+
+/*
+    W O R L D
+*/
+
+#define CCE_WORLD_SPILL_CLASSES 18 // spill slots of 64 B .. 8 MB
+
+// One chunk of a world layer, keyed by world chunk coordinates (pixel = c * chunk_size + local).
+typedef struct CCE_WorldChunk
+{
+    int cx, cy;
+    CCE_Color* data;    // chunk_size * chunk_size pixels, NULL while uniform
+    bool uniform;       // every pixel equals `fill`
+    CCE_Color fill;
+    bool dirty;         // resident tile is stale inside the dirty rect
+    int dirty_x0, dirty_y0, dirty_x1, dirty_y1;
+    int tile;           // slot in the GPU tile pool, -1 when not resident
+    struct CCE_WorldChunk* next; // hash bucket chain
+
+    // Off-screen residency: pixels are either raw (`data`), compressed in RAM (`packed`) or
+    // compressed in the spill file; they are unpacked on the next access.
+    unsigned char* packed;
+    int packed_size;
+    bool spilled;
+    int spill_class;
+    long spill_offset;
+    unsigned long last_used; // world frame of the last access
+    struct CCE_WorldChunk* lru_prev; // raw or packed LRU list, most recent first
+    struct CCE_WorldChunk* lru_next;
+} CCE_WorldChunk;
+
+typedef struct
+{
+    CCE_WorldChunk* head;
+    CCE_WorldChunk* tail;
+} CCE_WorldList;
+
+typedef struct
+{
+    size_t raw_bytes;     // uncompressed chunk pixels in RAM
+    size_t packed_bytes;  // compressed chunk pixels in RAM
+    size_t spilled_bytes; // compressed chunk pixels in the spill file
+    int raw_chunks, packed_chunks, spilled_chunks;
+} CCE_WorldMemory;
+
+// Unbounded canvas addressed in world pixels. Chunks are created on first write; only chunks under
+// the viewport hold a tile in the GPU pool, so scrolling moves the camera instead of repainting.
+typedef struct
+{
+    char* name;
+    bool enabled;
+    int chunk_size;     // power of two
+    int chunk_shift;
+
+    CCE_WorldChunk** buckets;
+    int bucket_count;   // power of two
+    int chunk_count;
+    CCE_WorldChunk* last; // last chunk looked up (runs of writes stay in one chunk)
+
+    // World pixel shown at the top-left corner of the viewport.
+    int camera_x, camera_y;
+    int view_w, view_h;
+
+    // Fixed tile pool: one atlas texture of tiles_x * tiles_y chunk-sized tiles.
+    unsigned int atlas;
+    int tiles_x, tiles_y;
+    CCE_WorldChunk** tile_owner;
+    int* free_tiles;
+    int free_count;
+    float* verts;       // quad scratch for one draw of every tile
+    struct CCE_TextureRect* uploads; // tile writes queued by one render_world
+
+    // Residency (see cce_world_set_residency).
+    unsigned long frame;
+    int idle_frames;
+    size_t budget_bytes;
+    CCE_WorldList raw_lru;
+    CCE_WorldList packed_lru;
+    CCE_WorldMemory memory;
+    int spill_fd;
+    unsigned char* spill_map;
+    size_t spill_size;  // mapped bytes
+    size_t spill_end;   // first never-used byte
+    long* spill_free[CCE_WORLD_SPILL_CLASSES]; // recycled slot offsets per size class
+    int spill_free_count[CCE_WORLD_SPILL_CLASSES];
+    int spill_free_cap[CCE_WORLD_SPILL_CLASSES];
+} CCE_WorldLayer;
+
+// chunk_size must be a power of two in 16..1024 (0 = 128). Requires an active GL context.
+CCE_WorldLayer* cce_world_create(int view_w, int view_h, char * name, int chunk_size);
+void cce_world_destroy(CCE_WorldLayer* world);
+void cce_world_set_camera(CCE_WorldLayer* world, int world_x, int world_y);
+void cce_world_set_pixel(CCE_WorldLayer* world, int world_x, int world_y, CCE_Color color);
+// Transparent where nothing was drawn.
+CCE_Color cce_world_get_pixel(CCE_WorldLayer* world, int world_x, int world_y);
+// Fills world rect [x0..x1]x[y0..y1] (inclusive); fully covered chunks become uniform.
+void cce_world_set_pixel_rect(CCE_WorldLayer* world, int x0, int y0, int x1, int y1, CCE_Color color);
+// Drops every chunk.
+void cce_world_clear(CCE_WorldLayer* world);
+// Off-screen chunks untouched for `idle_frames` rendered frames are compressed (0 disables).
+// With a non-zero budget, raw plus compressed pixels in RAM are kept under `budget_bytes`:
+// least recently used chunks are compressed first, then moved to a memory-mapped spill file.
+// Chunks under the viewport always stay raw, so the budget cannot go below one screen of chunks.
+int cce_world_set_residency(CCE_WorldLayer* world, size_t budget_bytes, int idle_frames);
+int cce_world_get_memory(const CCE_WorldLayer* world, CCE_WorldMemory* out);
+// Uploads the visible chunks that changed or just scrolled in, then draws the viewport.
+// Also runs the residency pass for chunks outside the view.
+void render_world(CCE_WorldLayer* world);
+
 /*
     T E X T
 */
@@ -357,6 +705,20 @@ typedef struct
 int cce_sprite_load(CCE_Sprite* out);
 void cce_sprite_free(CCE_Sprite* img);
 int cce_draw_sprite(CCE_Layer* layer, const CCE_Sprite* sprite, int dst_x, int dst_y, int batch_size, CCE_Color modifier, int frame_step_px, int current_step);
+
+typedef enum
+{
+    CCE_FLIP_NONE = 0,
+    CCE_FLIP_H = 1,
+    CCE_FLIP_V = 2,
+} CCE_SpriteFlip;
+
+// Like cce_draw_sprite, but placed by the frame centre (bottom-left screen coordinates), with
+// fractional per-axis scale, rotation in radians (counter-clockwise on screen) and a CCE_SpriteFlip mask.
+// Sampling is nearest-neighbour, so pixel art stays crisp at any angle.
+int cce_draw_sprite_ex(CCE_Layer* layer, const CCE_Sprite* sprite, float center_x, float center_y,
+                       float scale_x, float scale_y, float angle, int flip, CCE_Color modifier,
+                       int frame_step_px, int current_step);
 void cce_sprite_calc_frame_uv(const CCE_Texture* tex, int frame_width_px, int frame_index, float* u0, float* u1);
 
 /*
@@ -31,10 +31,14 @@ SOFTWARE.
 
 extern long engine_seed;
 extern int engine_msaa;
+extern int engine_threads;
+extern int engine_chunk_size;
 
 #define ERRLOG fprintf(stderr, "CCE | ERROR: %s:%d\n", __FILE__, __LINE__)
 #define M_PI 3.14159265358979323846
 #define CHUNK_SIZE 135
+#define CCE_CHUNK_SIZE_MIN 16
+#define CCE_CHUNK_SIZE_MAX 1024
 #define COMPRESS(a, b, c) b + (a * c) / 255
 #define CCE_DEBUG 0
 
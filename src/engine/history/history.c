@@ -0,0 +1,241 @@
+/*
+===========================================================================
+MIT License
+
+Copyright (c) 2026 Stepan Pukhovskiy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+===========================================================================
+*/
+
+#include "history.h"
+#include "../engine.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+CCE_LayerSnapshot* cce_layer_snapshot(CCE_Layer* layer)
+{
+    // A locked span writes straight into chunk slots, which the snapshot would share.
+    if (!layer || layer->backend != CCE_LAYER_CPU || layer->lock_count > 0) {
+        ERRLOG;
+        return NULL;
+    }
+    const int count = layer->chunk_count_x * layer->chunk_count_y;
+    CCE_LayerSnapshot* snapshot = malloc(sizeof(CCE_LayerSnapshot) + (size_t)count * sizeof(CCE_SnapshotChunk));
+    if (!snapshot) {
+        ERRLOG;
+        return NULL;
+    }
+    snapshot->layer = layer;
+    snapshot->scr_w = layer->scr_w;
+    snapshot->scr_h = layer->scr_h;
+    snapshot->chunk_size = layer->chunk_size;
+    snapshot->chunk_count_x = layer->chunk_count_x;
+    snapshot->chunk_count_y = layer->chunk_count_y;
+
+    // No pixels are copied: non-uniform chunks hand out a reference to their slot.
+    for (int i = 0; i < count; i++) {
+        CCE_Chunk* chunk = &layer->chunks[i];
+        CCE_SnapshotChunk* entry = &snapshot->chunks[i];
+        entry->uniform = chunk->uniform;
+        entry->fill = chunk->fill;
+        entry->buffer = NULL;
+        if (chunk->uniform) continue;
+
+        if (!chunk->shared) {
+            CCE_ChunkBuffer* buffer = calloc(1, sizeof(CCE_ChunkBuffer));
+            if (!buffer) {
+                ERRLOG;
+                for (int j = 0; j < i; j++) {
+                    if (snapshot->chunks[j].buffer) cce_chunk_buffer_release(snapshot->chunks[j].buffer);
+                }
+                free(snapshot);
+                return NULL;
+            }
+            buffer->refs = 1;
+            buffer->w = chunk->w;
+            buffer->h = chunk->h;
+            buffer->slot = chunk->data;
+            chunk->shared = buffer;
+        }
+        chunk->shared->refs++;
+        entry->buffer = chunk->shared;
+    }
+    return snapshot;
+}
+
+int cce_layer_restore(CCE_Layer* layer, const CCE_LayerSnapshot* snapshot)
+{
+    if (!layer || !snapshot || snapshot->layer != layer || snapshot->chunk_size != layer->chunk_size ||
+        snapshot->scr_w != layer->scr_w || snapshot->scr_h != layer->scr_h || layer->lock_count > 0) {
+        ERRLOG;
+        return -1;
+    }
+    const int count = layer->chunk_count_x * layer->chunk_count_y;
+    for (int i = 0; i < count; i++) {
+        CCE_Chunk* chunk = &layer->chunks[i];
+        const CCE_SnapshotChunk* entry = &snapshot->chunks[i];
+        if (entry->uniform) {
+            cce_chunk_set_uniform(layer, chunk, entry->fill);
+            continue;
+        }
+
+        CCE_ChunkBuffer* buffer = entry->buffer;
+        if (chunk->shared == buffer) {
+            // Not written since: the slot still holds the snapshot's pixels.
+            if (chunk->uniform) {
+                chunk->uniform = false;
+                cce_chunk_mark_dirty(layer, chunk, 0, 0, chunk->w - 1, chunk->h - 1);
+            }
+            continue;
+        }
+        if (!buffer->pixels) {
+            ERRLOG;
+            continue;
+        }
+
+        // Copy back into the slot and let the buffer share it again, so the copy is held once.
+        if (chunk->shared) cce_chunk_unshare(chunk);
+        if (chunk->uniform) cce_chunk_back(layer, chunk, 0);
+        memcpy(chunk->data, buffer->pixels, (size_t)chunk->w * (size_t)chunk->h * sizeof(CCE_Color));
+        free(buffer->pixels);
+        buffer->pixels = NULL;
+        buffer->slot = chunk->data;
+        buffer->refs++;
+        chunk->shared = buffer;
+        cce_chunk_mark_dirty(layer, chunk, 0, 0, chunk->w - 1, chunk->h - 1);
+    }
+    return 0;
+}
+
+CCE_Color cce_layer_snapshot_get_pixel(const CCE_LayerSnapshot* snapshot, int x, int y)
+{
+    const CCE_Color none = { 0, 0, 0, 0 };
+    if (!snapshot || x < 0 || y < 0 || x >= snapshot->scr_w || y >= snapshot->scr_h) return none;
+    const int cs = snapshot->chunk_size;
+    const CCE_SnapshotChunk* entry = &snapshot->chunks[(y / cs) * snapshot->chunk_count_x + x / cs];
+    if (entry->uniform) return entry->fill;
+    const CCE_Color* pixels = cce_chunk_buffer_pixels(entry->buffer);
+    if (!pixels) return none;
+    return pixels[(y % cs) * entry->buffer->w + x % cs];
+}
+
+void cce_layer_snapshot_free(CCE_LayerSnapshot* snapshot)
+{
+    if (!snapshot) return;
+    const int count = snapshot->chunk_count_x * snapshot->chunk_count_y;
+    for (int i = 0; i < count; i++) {
+        if (snapshot->chunks[i].buffer) cce_chunk_buffer_release(snapshot->chunks[i].buffer);
+    }
+    free(snapshot);
+}
+
+CCE_UndoHistory* cce_undo_create(CCE_Layer* layer, int depth)
+{
+    if (!layer || layer->backend != CCE_LAYER_CPU || depth < 1) {
+        ERRLOG;
+        return NULL;
+    }
+    CCE_UndoHistory* history = calloc(1, sizeof(CCE_UndoHistory));
+    if (!history) {
+        ERRLOG;
+        return NULL;
+    }
+    history->states = calloc((size_t)depth + 1, sizeof(CCE_LayerSnapshot*));
+    if (history->states) history->states[0] = cce_layer_snapshot(layer);
+    if (!history->states || !history->states[0]) {
+        ERRLOG;
+        free(history->states);
+        free(history);
+        return NULL;
+    }
+    history->layer = layer;
+    history->depth = depth;
+    history->count = 1;
+    history->current = 0;
+    return history;
+}
+
+int cce_undo_commit(CCE_UndoHistory* history)
+{
+    if (!history) {
+        ERRLOG;
+        return -1;
+    }
+    CCE_LayerSnapshot* snapshot = cce_layer_snapshot(history->layer);
+    if (!snapshot) return -1;
+
+    // A new edit drops the redo branch, then the oldest state once the ring is full.
+    for (int i = history->current + 1; i < history->count; i++) cce_layer_snapshot_free(history->states[i]);
+    history->count = history->current + 1;
+    if (history->count == history->depth + 1) {
+        cce_layer_snapshot_free(history->states[0]);
+        memmove(history->states, history->states + 1, (size_t)history->depth * sizeof(CCE_LayerSnapshot*));
+        history->count--;
+    }
+    history->states[history->count++] = snapshot;
+    history->current = history->count - 1;
+    return 0;
+}
+
+int cce_undo(CCE_UndoHistory* history)
+{
+    if (!history || history->current == 0) return -1;
+    // The position only moves once the restore went through (it fails while the layer is locked).
+    if (cce_layer_restore(history->layer, history->states[history->current - 1]) != 0) return -1;
+    history->current--;
+    return 0;
+}
+
+int cce_redo(CCE_UndoHistory* history)
+{
+    if (!history || history->current + 1 >= history->count) return -1;
+    if (cce_layer_restore(history->layer, history->states[history->current + 1]) != 0) return -1;
+    history->current++;
+    return 0;
+}
+
+size_t cce_undo_get_memory(const CCE_UndoHistory* history)
+{
+    static unsigned epoch = 0;
+    if (!history) return 0;
+    epoch++;
+    size_t bytes = 0;
+    for (int s = 0; s < history->count; s++) {
+        const CCE_LayerSnapshot* snapshot = history->states[s];
+        const int count = snapshot->chunk_count_x * snapshot->chunk_count_y;
+        for (int i = 0; i < count; i++) {
+            CCE_ChunkBuffer* buffer = snapshot->chunks[i].buffer;
+            if (!buffer || buffer->mark == epoch) continue;
+            buffer->mark = epoch;
+            if (buffer->pixels) bytes += (size_t)buffer->w * (size_t)buffer->h * sizeof(CCE_Color);
+        }
+    }
+    return bytes;
+}
+
+void cce_undo_destroy(CCE_UndoHistory* history)
+{
+    if (!history) return;
+    for (int i = 0; i < history->count; i++) cce_layer_snapshot_free(history->states[i]);
+    free(history->states);
+    free(history);
+}
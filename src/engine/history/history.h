@@ -0,0 +1,60 @@
+/*
+===========================================================================
+MIT License
+
+Copyright (c) 2026 Stepan Pukhovskiy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+===========================================================================
+*/
+
+#ifndef CCE_HISTORY_GUARD_H
+#define CCE_HISTORY_GUARD_H
+
+#include "../../cce.h"
+#include "../render/render.h"
+
+// One chunk of a snapshot: a uniform colour, or shared pixel storage.
+typedef struct
+{
+    bool uniform;
+    CCE_Color fill;
+    CCE_ChunkBuffer* buffer;
+} CCE_SnapshotChunk;
+
+struct CCE_LayerSnapshot
+{
+    const CCE_Layer* layer;
+    int scr_w, scr_h;
+    int chunk_size;
+    int chunk_count_x, chunk_count_y;
+    CCE_SnapshotChunk chunks[];
+};
+
+struct CCE_UndoHistory
+{
+    CCE_Layer* layer;
+    int depth;
+    // states[0..count) oldest first; `current` is the state the layer is in.
+    CCE_LayerSnapshot** states;
+    int count;
+    int current;
+};
+
+#endif
@@ -26,6 +26,8 @@ SOFTWARE.
 
 #include "init.h"
 #include "../engine.h"
+#include "../kernel/kernel.h"
+#include "../thread/thread.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -36,6 +38,8 @@ SOFTWARE.
 static int cce_initialized = 0;
 long engine_seed = 10567348921509346;
 int engine_msaa = 0;
+int engine_threads = 0;
+int engine_chunk_size = CHUNK_SIZE;
 RandPack RP;
 
 void cce_printf(const char* format, ...)
@@ -93,12 +97,16 @@ int cce_engine_init(void)
     cce_printf("R8 - %d\n", RP.r8);
     cce_printf("R9 - %d\n", RP.r9);
 
+    cce_kernel_init();
+
     return 0;
 }
 
 void cce_engine_cleanup(void)
 {
     cce_printf("Cleaning up CCE...\n");
+
+    cce_thread_pool_shutdown();
     
     if (cce_initialized)
     {
@@ -127,8 +135,20 @@ long get_engine_seed(void)
 void set_engine_msaa(int factor)
 { engine_msaa = factor; }
 
+void set_engine_threads(int count)
+{ engine_threads = count; }
+
+void set_engine_chunk_size(int size)
+{
+    if (size < CCE_CHUNK_SIZE_MIN || size > CCE_CHUNK_SIZE_MAX) {
+        ERRLOG;
+        return;
+    }
+    engine_chunk_size = size;
+}
+
 int get_engine_chunk_size(void)
-{ return CHUNK_SIZE; }
+{ return engine_chunk_size; }
 
 int get_randpack_value(RandPackIndex index)
 {
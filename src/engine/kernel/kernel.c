@@ -0,0 +1,1127 @@
+/*
+===========================================================================
+MIT License
+
+Copyright (c) 2026 Stepan Pukhovskiy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+===========================================================================
+*/
+
+#include "kernel.h"
+#include "../engine.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CCE_KERNEL_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#define CCE_KERNEL_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define div255 cce_div255
+#define channel cce_channel
+
+/* Scalar reference kernels */
+
+static void fill_scalar(uint32_t* dst, uint32_t value, size_t count)
+{
+    for (size_t i = 0; i < count; i++) dst[i] = value;
+}
+
+// Every ISA table uses this: libc memcpy is already vectorised and beat the hand-written SIMD copies.
+static void copy_scalar(uint32_t* dst, const uint32_t* src, size_t count)
+{
+    memcpy(dst, src, count * sizeof(uint32_t));
+}
+
+static void blend_scalar(uint32_t* dst, const uint32_t* src, size_t count)
+{
+    for (size_t i = 0; i < count; i++) dst[i] = cce_pixel_over(src[i], dst[i]);
+}
+
+static void add_scalar(uint32_t* dst, const uint32_t* src, size_t count)
+{
+    for (size_t i = 0; i < count; i++) dst[i] = cce_pixel_add(src[i], dst[i]);
+}
+
+static void multiply_scalar(uint32_t* dst, const uint32_t* src, size_t count)
+{
+    for (size_t i = 0; i < count; i++) dst[i] = cce_pixel_multiply(src[i], dst[i]);
+}
+
+static inline uint32_t modulate_pixel(uint32_t s, uint32_t t)
+{
+    uint32_t out = 0;
+    for (int sh = 0; sh < 32; sh += 8) {
+        out |= div255(channel(s, sh) * channel(t, sh)) << sh;
+    }
+    return out;
+}
+
+static void modulate_scalar(uint32_t* dst, const uint32_t* src, size_t count, uint32_t tint)
+{
+    for (size_t i = 0; i < count; i++) dst[i] = modulate_pixel(src[i], tint);
+}
+
+static void coverage_scalar(uint32_t* dst, const uint8_t* coverage, size_t count, uint32_t color)
+{
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t c = coverage[i];
+        if (c) dst[i] = modulate_pixel(c * 0x01010101u, color);
+    }
+}
+
+#define CCE_HASH_P1 2654435761u
+#define CCE_HASH_P2 2246822519u
+// Independent lanes keep several multiplies in flight; SIMD variants hold them in 4-8 registers.
+#define CCE_HASH_LANES 32
+
+static inline uint32_t rotl32(uint32_t x, int r)
+{
+    return (x << r) | (x >> (32 - r));
+}
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline void hash_lanes_init(uint32_t acc[CCE_HASH_LANES], uint64_t seed)
+{
+    for (int l = 0; l < CCE_HASH_LANES; l++) {
+        acc[l] = (uint32_t)seed + (uint32_t)(seed >> 32) + CCE_HASH_P1 * (uint32_t)(l + 1);
+    }
+}
+
+// Folds the lanes, mixes in the tail pixels and avalanches (xxHash64 constants).
+static uint64_t hash_finish(const uint32_t acc[CCE_HASH_LANES], const uint32_t* tail, size_t tail_count, size_t count)
+{
+    const uint64_t p1 = 11400714785074694791ull;
+    const uint64_t p2 = 14029467366897019727ull;
+    const uint64_t p3 = 1609587929392839161ull;
+    uint64_t h = (uint64_t)count * p3;
+    for (int l = 0; l < CCE_HASH_LANES; l++) {
+        h ^= (uint64_t)acc[l] * p2;
+        h = rotl64(h, 31) * p1;
+    }
+    for (size_t i = 0; i < tail_count; i++) {
+        h ^= (uint64_t)tail[i] * p1;
+        h = rotl64(h, 23) * p2 + p3;
+    }
+    h ^= h >> 33;
+    h *= p2;
+    h ^= h >> 29;
+    h *= p3;
+    h ^= h >> 32;
+    return h;
+}
+
+static uint64_t hash_scalar(const uint32_t* src, size_t count, uint64_t seed)
+{
+    uint32_t acc[CCE_HASH_LANES];
+    hash_lanes_init(acc, seed);
+    size_t i = 0;
+    for (; i + CCE_HASH_LANES <= count; i += CCE_HASH_LANES) {
+        for (int l = 0; l < CCE_HASH_LANES; l++) {
+            acc[l] = rotl32(acc[l] + src[i + l] * CCE_HASH_P2, 13) * CCE_HASH_P1;
+        }
+    }
+    return hash_finish(acc, src + i, count - i, count);
+}
+
+static void sample_scalar(uint32_t* dst, const uint32_t* src, size_t stride,
+                          int32_t u, int32_t v, int32_t du, int32_t dv, size_t count)
+{
+    for (size_t i = 0; i < count; i++, u += du, v += dv) {
+        dst[i] = src[(size_t)(v >> 16) * stride + (size_t)(u >> 16)];
+    }
+}
+
+static void palette_scalar(uint32_t* dst, const uint32_t* lut, uint32_t x, uint32_t y, uint32_t step,
+                           uint32_t seed, size_t count)
+{
+    for (size_t i = 0; i < count; i++, x += step) {
+        dst[i] = lut[cce_noise_byte(x, y, seed)];
+    }
+}
+
+// Noise math keeps every product in its own statement: nothing can be fused into an FMA,
+// so the vector kernels below reproduce the scalar results bit for bit.
+static inline float noise_fade(float t)
+{
+    float p = t * 6.0f;
+    p = p - 15.0f;
+    p = t * p;
+    p = p + 10.0f;
+    const float t3 = t * t * t;
+    return t3 * p;
+}
+
+static inline float noise_lerp(float a, float b, float t)
+{
+    const float d = (b - a) * t;
+    return a + d;
+}
+
+// Corner contribution: a hashed value, or the dot product with one of four diagonal gradients.
+static inline float noise_corner(uint32_t h, float dx, float dy, CCE_NoiseType type)
+{
+    if (type == CCE_NOISE_VALUE) {
+        const float v = (float)(h >> 8) * 0x1p-23f;
+        return v - 1.0f;
+    }
+    const float gx = (h & 1u) ? dx : -dx;
+    const float gy = (h & 2u) ? dy : -dy;
+    return gx + gy;
+}
+
+// Lanes [from, count) of a noise row; the vector kernels finish their tails here.
+static void noise_row_scalar(float* dst, float x, float y, float frequency, uint32_t seed, CCE_NoiseType type,
+                             size_t from, size_t count)
+{
+    const float py = y * frequency;
+    const float fy = floorf(py);
+    const float ty = py - fy;
+    const float ty1 = ty - 1.0f;
+    const float v = noise_fade(ty);
+    const uint32_t iy = (uint32_t)(int32_t)fy;
+    for (size_t i = from; i < count; i++) {
+        const float px = (x + (float)i) * frequency;
+        const float fx = floorf(px);
+        const float tx = px - fx;
+        const float tx1 = tx - 1.0f;
+        const float u = noise_fade(tx);
+        const uint32_t ix = (uint32_t)(int32_t)fx;
+        const float n00 = noise_corner(cce_noise_hash(ix, iy, seed), tx, ty, type);
+        const float n10 = noise_corner(cce_noise_hash(ix + 1u, iy, seed), tx1, ty, type);
+        const float n01 = noise_corner(cce_noise_hash(ix, iy + 1u, seed), tx, ty1, type);
+        const float n11 = noise_corner(cce_noise_hash(ix + 1u, iy + 1u, seed), tx1, ty1, type);
+        dst[i] = noise_lerp(noise_lerp(n00, n10, u), noise_lerp(n01, n11, u), v);
+    }
+}
+
+static void noise_scalar(float* dst, float x, float y, float frequency, uint32_t seed, CCE_NoiseType type, size_t count)
+{
+    noise_row_scalar(dst, x, y, frequency, seed, type, 0, count);
+}
+
+const CCE_KernelTable cce_scalar_kernels = {
+    .name = "scalar",
+    .fill = fill_scalar,
+    .copy = copy_scalar,
+    .blend = blend_scalar,
+    .add = add_scalar,
+    .multiply = multiply_scalar,
+    .modulate = modulate_scalar,
+    .coverage = coverage_scalar,
+    .sample = sample_scalar,
+    .palette = palette_scalar,
+    .noise = noise_scalar,
+    .hash = hash_scalar,
+};
+
+CCE_KernelTable cce_kernels = {
+    .name = "scalar",
+    .fill = fill_scalar,
+    .copy = copy_scalar,
+    .blend = blend_scalar,
+    .add = add_scalar,
+    .multiply = multiply_scalar,
+    .modulate = modulate_scalar,
+    .coverage = coverage_scalar,
+    .sample = sample_scalar,
+    .palette = palette_scalar,
+    .noise = noise_scalar,
+    .hash = hash_scalar,
+};
+
+#if defined(CCE_KERNEL_X86)
+
+/* SSE2: 4 pixels per step, channels widened to 16 bits */
+
+#define CCE_SSE2 __attribute__((target("sse2")))
+#define CCE_AVX2 __attribute__((target("avx2")))
+
+CCE_SSE2 static inline __m128i div255_sse2(__m128i x)
+{
+    x = _mm_add_epi16(x, _mm_set1_epi16(1));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+CCE_SSE2 static void fill_sse2(uint32_t* dst, uint32_t value, size_t count)
+{
+    const __m128i v = _mm_set1_epi32((int)value);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        _mm_storeu_si128((__m128i*)(dst + i), v);
+        _mm_storeu_si128((__m128i*)(dst + i + 4), v);
+        _mm_storeu_si128((__m128i*)(dst + i + 8), v);
+        _mm_storeu_si128((__m128i*)(dst + i + 12), v);
+    }
+    for (; i + 4 <= count; i += 4) _mm_storeu_si128((__m128i*)(dst + i), v);
+    for (; i < count; i++) dst[i] = value;
+}
+
+// Blends two pixels widened to 16-bit lanes.
+CCE_SSE2 static inline __m128i blend_half_sse2(__m128i s, __m128i d)
+{
+    const __m128i rgb_mask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i alpha_one = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    const __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xFF), 0xFF);
+    // Source alpha lane is weighted by 255 so out.a = sa + da * (1 - sa).
+    const __m128i sw = _mm_or_si128(_mm_and_si128(a, rgb_mask), alpha_one);
+    const __m128i ia = _mm_sub_epi16(_mm_set1_epi16(255), a);
+    return div255_sse2(_mm_add_epi16(_mm_mullo_epi16(s, sw), _mm_mullo_epi16(d, ia)));
+}
+
+CCE_SSE2 static void blend_sse2(uint32_t* dst, const uint32_t* src, size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i amask = _mm_set1_epi32((int)0xFF000000u);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        const __m128i sa = _mm_and_si128(s, amask);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(sa, zero)) == 0xFFFF) continue;
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(sa, amask)) == 0xFFFF) {
+            _mm_storeu_si128((__m128i*)(dst + i), s);
+            continue;
+        }
+        const __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        const __m128i lo = blend_half_sse2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+        const __m128i hi = blend_half_sse2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    blend_scalar(dst + i, src + i, count - i);
+}
+
+// Source weighted by its alpha (alpha lane by 255), widened to 16-bit lanes.
+CCE_SSE2 static inline __m128i premul_half_sse2(__m128i s)
+{
+    const __m128i rgb_mask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i alpha_one = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    const __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xFF), 0xFF);
+    return div255_sse2(_mm_mullo_epi16(s, _mm_or_si128(_mm_and_si128(a, rgb_mask), alpha_one)));
+}
+
+CCE_SSE2 static void add_sse2(uint32_t* dst, const uint32_t* src, size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i amask = _mm_set1_epi32((int)0xFF000000u);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, amask), zero)) == 0xFFFF) continue;
+        const __m128i p = _mm_packus_epi16(premul_half_sse2(_mm_unpacklo_epi8(s, zero)),
+                                           premul_half_sse2(_mm_unpackhi_epi8(s, zero)));
+        const __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_adds_epu8(d, p));
+    }
+    add_scalar(dst + i, src + i, count - i);
+}
+
+CCE_SSE2 static inline __m128i multiply_half_sse2(__m128i s, __m128i d)
+{
+    const __m128i rgb_mask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i alpha_one = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    const __m128i c255 = _mm_set1_epi16(255);
+    const __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xFF), 0xFF);
+    __m128i f = div255_sse2(_mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(c255, _mm_sub_epi16(c255, a))));
+    // Alpha lane factor is 1 so dst alpha is kept.
+    f = _mm_or_si128(_mm_and_si128(f, rgb_mask), alpha_one);
+    return div255_sse2(_mm_mullo_epi16(d, f));
+}
+
+CCE_SSE2 static void multiply_sse2(uint32_t* dst, const uint32_t* src, size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i amask = _mm_set1_epi32((int)0xFF000000u);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, amask), zero)) == 0xFFFF) continue;
+        const __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        const __m128i lo = multiply_half_sse2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+        const __m128i hi = multiply_half_sse2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    multiply_scalar(dst + i, src + i, count - i);
+}
+
+CCE_SSE2 static void modulate_sse2(uint32_t* dst, const uint32_t* src, size_t count, uint32_t tint)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i t = _mm_unpacklo_epi8(_mm_set1_epi32((int)tint), zero);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        const __m128i lo = div255_sse2(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), t));
+        const __m128i hi = div255_sse2(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), t));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    modulate_scalar(dst + i, src + i, count - i, tint);
+}
+
+CCE_SSE2 static void coverage_sse2(uint32_t* dst, const uint8_t* coverage, size_t count, uint32_t color)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i col = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint32_t c4;
+        memcpy(&c4, coverage + i, sizeof(c4));
+        if (!c4) continue;
+        // Spread each coverage byte over its pixel's four channels.
+        __m128i c = _mm_cvtsi32_si128((int)c4);
+        c = _mm_unpacklo_epi8(c, c);
+        c = _mm_unpacklo_epi16(c, c);
+        const __m128i lo = div255_sse2(_mm_mullo_epi16(_mm_unpacklo_epi8(c, zero), col));
+        const __m128i hi = div255_sse2(_mm_mullo_epi16(_mm_unpackhi_epi8(c, zero), col));
+        const __m128i v = _mm_packus_epi16(lo, hi);
+        const __m128i keep = _mm_cmpeq_epi8(c, zero);
+        const __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_and_si128(keep, d), _mm_andnot_si128(keep, v)));
+    }
+    coverage_scalar(dst + i, coverage + i, count - i, color);
+}
+
+// SSE2 has no 32-bit mullo: multiply even and odd lanes as 64-bit and interleave the low halves.
+CCE_SSE2 static inline __m128i mullo32_sse2(__m128i a, __m128i b)
+{
+    const __m128i even = _mm_mul_epu32(a, b);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+CCE_SSE2 static inline __m128i hash_round_sse2(__m128i acc, __m128i v, __m128i p1, __m128i p2)
+{
+    acc = _mm_add_epi32(acc, mullo32_sse2(v, p2));
+    acc = _mm_or_si128(_mm_slli_epi32(acc, 13), _mm_srli_epi32(acc, 19));
+    return mullo32_sse2(acc, p1);
+}
+
+CCE_SSE2 static uint64_t hash_sse2(const uint32_t* src, size_t count, uint64_t seed)
+{
+    uint32_t acc[CCE_HASH_LANES];
+    hash_lanes_init(acc, seed);
+    const __m128i p1 = _mm_set1_epi32((int)CCE_HASH_P1);
+    const __m128i p2 = _mm_set1_epi32((int)CCE_HASH_P2);
+    __m128i a[CCE_HASH_LANES / 4];
+    for (int v = 0; v < CCE_HASH_LANES / 4; v++) a[v] = _mm_loadu_si128((const __m128i*)(acc + v * 4));
+    size_t i = 0;
+    for (; i + CCE_HASH_LANES <= count; i += CCE_HASH_LANES) {
+        for (int v = 0; v < CCE_HASH_LANES / 4; v++) {
+            a[v] = hash_round_sse2(a[v], _mm_loadu_si128((const __m128i*)(src + i + v * 4)), p1, p2);
+        }
+    }
+    for (int v = 0; v < CCE_HASH_LANES / 4; v++) _mm_storeu_si128((__m128i*)(acc + v * 4), a[v]);
+    return hash_finish(acc, src + i, count - i, count);
+}
+
+// cce_noise_hash for four cells; `xa` holds x * 1836311903, `k` the row and seed terms.
+CCE_SSE2 static inline __m128i noise_hash_sse2(__m128i xa, __m128i k)
+{
+    __m128i n = _mm_xor_si128(xa, k);
+    n = _mm_xor_si128(_mm_srli_epi32(n, 13), n);
+    const __m128i inner = _mm_add_epi32(mullo32_sse2(mullo32_sse2(n, n), _mm_set1_epi32(60493)), _mm_set1_epi32(19990303));
+    return _mm_add_epi32(mullo32_sse2(n, inner), _mm_set1_epi32(1376312589));
+}
+
+CCE_SSE2 static inline __m128i noise_byte_sse2(__m128i xa, __m128i k)
+{
+    const __m128i n = noise_hash_sse2(xa, k);
+    // 2147483647.0f rounds to 2^31, so the scalar division is an exact multiply by 2^-31.
+    const __m128 f = _mm_cvtepi32_ps(_mm_and_si128(n, _mm_set1_epi32(0x7FFFFFFF)));
+    return _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(f, _mm_set1_ps(0x1p-31f)), _mm_set1_ps(255.0f)));
+}
+
+CCE_SSE2 static void palette_sse2(uint32_t* dst, const uint32_t* lut, uint32_t x, uint32_t y, uint32_t step,
+                                  uint32_t seed, size_t count)
+{
+    const uint32_t ax = x * 1836311903u;
+    const uint32_t as = step * 1836311903u;
+    const __m128i k = _mm_set1_epi32((int)((y * 2971215073u) ^ (seed * 1073741827u)));
+    __m128i xa = _mm_setr_epi32((int)ax, (int)(ax + as), (int)(ax + 2 * as), (int)(ax + 3 * as));
+    const __m128i xstep = _mm_set1_epi32((int)(4 * as));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint32_t idx[4];
+        _mm_storeu_si128((__m128i*)idx, noise_byte_sse2(xa, k));
+        dst[i + 0] = lut[idx[0]];
+        dst[i + 1] = lut[idx[1]];
+        dst[i + 2] = lut[idx[2]];
+        dst[i + 3] = lut[idx[3]];
+        xa = _mm_add_epi32(xa, xstep);
+    }
+    palette_scalar(dst + i, lut, x + (uint32_t)i * step, y, step, seed, count - i);
+}
+
+CCE_SSE2 static inline __m128 noise_fade_sse2(__m128 t)
+{
+    __m128 p = _mm_mul_ps(t, _mm_set1_ps(6.0f));
+    p = _mm_sub_ps(p, _mm_set1_ps(15.0f));
+    p = _mm_mul_ps(t, p);
+    p = _mm_add_ps(p, _mm_set1_ps(10.0f));
+    return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), p);
+}
+
+CCE_SSE2 static inline __m128 noise_lerp_sse2(__m128 a, __m128 b, __m128 t)
+{
+    return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+}
+
+CCE_SSE2 static inline __m128 noise_corner_sse2(__m128i h, __m128 dx, __m128 dy, CCE_NoiseType type)
+{
+    if (type == CCE_NOISE_VALUE) {
+        const __m128 v = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(h, 8)), _mm_set1_ps(0x1p-23f));
+        return _mm_sub_ps(v, _mm_set1_ps(1.0f));
+    }
+    // A clear hash bit flips the sign of its coordinate.
+    const __m128i sx = _mm_slli_epi32(_mm_andnot_si128(h, _mm_set1_epi32(1)), 31);
+    const __m128i sy = _mm_slli_epi32(_mm_andnot_si128(h, _mm_set1_epi32(2)), 30);
+    return _mm_add_ps(_mm_xor_ps(dx, _mm_castsi128_ps(sx)), _mm_xor_ps(dy, _mm_castsi128_ps(sy)));
+}
+
+CCE_SSE2 static void noise_sse2(float* dst, float x, float y, float frequency, uint32_t seed, CCE_NoiseType type, size_t count)
+{
+    const float py = y * frequency;
+    const float fy = floorf(py);
+    const uint32_t iy = (uint32_t)(int32_t)fy;
+    const __m128 ty = _mm_set1_ps(py - fy);
+    const __m128 ty1 = _mm_sub_ps(ty, _mm_set1_ps(1.0f));
+    const __m128 v = noise_fade_sse2(ty);
+    const __m128i k0 = _mm_set1_epi32((int)((iy * 2971215073u) ^ (seed * 1073741827u)));
+    const __m128i k1 = _mm_set1_epi32((int)(((iy + 1u) * 2971215073u) ^ (seed * 1073741827u)));
+    const __m128i ax = _mm_set1_epi32((int)1836311903u);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 fx0 = _mm_set1_ps(x);
+    const __m128 freq = _mm_set1_ps(frequency);
+    __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 px = _mm_mul_ps(_mm_add_ps(fx0, lane), freq);
+        // floor without SSE4.1: truncate, then step down where that rounded up.
+        __m128i ix = _mm_cvttps_epi32(px);
+        ix = _mm_add_epi32(ix, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(ix), px)));
+        const __m128 tx = _mm_sub_ps(px, _mm_cvtepi32_ps(ix));
+        const __m128 tx1 = _mm_sub_ps(tx, one);
+        const __m128 u = noise_fade_sse2(tx);
+        const __m128i xa = mullo32_sse2(ix, ax);
+        const __m128i xa1 = _mm_add_epi32(xa, ax);
+        const __m128 n00 = noise_corner_sse2(noise_hash_sse2(xa, k0), tx, ty, type);
+        const __m128 n10 = noise_corner_sse2(noise_hash_sse2(xa1, k0), tx1, ty, type);
+        const __m128 n01 = noise_corner_sse2(noise_hash_sse2(xa, k1), tx, ty1, type);
+        const __m128 n11 = noise_corner_sse2(noise_hash_sse2(xa1, k1), tx1, ty1, type);
+        _mm_storeu_ps(dst + i, noise_lerp_sse2(noise_lerp_sse2(n00, n10, u), noise_lerp_sse2(n01, n11, u), v));
+        lane = _mm_add_ps(lane, _mm_set1_ps(4.0f));
+    }
+    noise_row_scalar(dst, x, y, frequency, seed, type, i, count);
+}
+
+/* AVX2: 8 pixels per step; unpack/pack work per 128-bit lane so the order is preserved */
+
+CCE_AVX2 static inline __m256i div255_avx2(__m256i x)
+{
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(1));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+CCE_AVX2 static void fill_avx2(uint32_t* dst, uint32_t value, size_t count)
+{
+    const __m256i v = _mm256_set1_epi32((int)value);
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        _mm256_storeu_si256((__m256i*)(dst + i), v);
+        _mm256_storeu_si256((__m256i*)(dst + i + 8), v);
+        _mm256_storeu_si256((__m256i*)(dst + i + 16), v);
+        _mm256_storeu_si256((__m256i*)(dst + i + 24), v);
+    }
+    for (; i + 8 <= count; i += 8) _mm256_storeu_si256((__m256i*)(dst + i), v);
+    // Clear the upper lanes before the SSE tail: legacy SSE code after dirty ymm state stalls.
+    _mm256_zeroupper();
+    fill_sse2(dst + i, value, count - i);
+}
+
+CCE_AVX2 static inline __m256i blend_half_avx2(__m256i s, __m256i d)
+{
+    const __m256i rgb_mask = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+    const __m256i alpha_one = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+    const __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xFF), 0xFF);
+    const __m256i sw = _mm256_or_si256(_mm256_and_si256(a, rgb_mask), alpha_one);
+    const __m256i ia = _mm256_sub_epi16(_mm256_set1_epi16(255), a);
+    return div255_avx2(_mm256_add_epi16(_mm256_mullo_epi16(s, sw), _mm256_mullo_epi16(d, ia)));
+}
+
+CCE_AVX2 static void blend_avx2(uint32_t* dst, const uint32_t* src, size_t count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i amask = _mm256_set1_epi32((int)0xFF000000u);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        const __m256i sa = _mm256_and_si256(s, amask);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(sa, zero)) == -1) continue;
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(sa, amask)) == -1) {
+            _mm256_storeu_si256((__m256i*)(dst + i), s);
+            continue;
+        }
+        const __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        const __m256i lo = blend_half_avx2(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero));
+        const __m256i hi = blend_half_avx2(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(lo, hi));
+    }
+    _mm256_zeroupper();
+    blend_sse2(dst + i, src + i, count - i);
+}
+
+CCE_AVX2 static inline __m256i premul_half_avx2(__m256i s)
+{
+    const __m256i rgb_mask = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+    const __m256i alpha_one = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+    const __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xFF), 0xFF);
+    return div255_avx2(_mm256_mullo_epi16(s, _mm256_or_si256(_mm256_and_si256(a, rgb_mask), alpha_one)));
+}
+
+CCE_AVX2 static void add_avx2(uint32_t* dst, const uint32_t* src, size_t count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i amask = _mm256_set1_epi32((int)0xFF000000u);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_and_si256(s, amask), zero)) == -1) continue;
+        const __m256i p = _mm256_packus_epi16(premul_half_avx2(_mm256_unpacklo_epi8(s, zero)),
+                                              premul_half_avx2(_mm256_unpackhi_epi8(s, zero)));
+        const __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_adds_epu8(d, p));
+    }
+    _mm256_zeroupper();
+    add_sse2(dst + i, src + i, count - i);
+}
+
+CCE_AVX2 static inline __m256i multiply_half_avx2(__m256i s, __m256i d)
+{
+    const __m256i rgb_mask = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+    const __m256i alpha_one = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+    const __m256i c255 = _mm256_set1_epi16(255);
+    const __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xFF), 0xFF);
+    __m256i f = div255_avx2(_mm256_add_epi16(_mm256_mullo_epi16(s, a), _mm256_mullo_epi16(c255, _mm256_sub_epi16(c255, a))));
+    f = _mm256_or_si256(_mm256_and_si256(f, rgb_mask), alpha_one);
+    return div255_avx2(_mm256_mullo_epi16(d, f));
+}
+
+CCE_AVX2 static void multiply_avx2(uint32_t* dst, const uint32_t* src, size_t count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i amask = _mm256_set1_epi32((int)0xFF000000u);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_and_si256(s, amask), zero)) == -1) continue;
+        const __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        const __m256i lo = multiply_half_avx2(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero));
+        const __m256i hi = multiply_half_avx2(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(lo, hi));
+    }
+    _mm256_zeroupper();
+    multiply_sse2(dst + i, src + i, count - i);
+}
+
+CCE_AVX2 static void modulate_avx2(uint32_t* dst, const uint32_t* src, size_t count, uint32_t tint)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i t = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)tint), zero);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        const __m256i lo = div255_avx2(_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), t));
+        const __m256i hi = div255_avx2(_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), t));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(lo, hi));
+    }
+    _mm256_zeroupper();
+    modulate_sse2(dst + i, src + i, count - i, tint);
+}
+
+CCE_AVX2 static void coverage_avx2(uint32_t* dst, const uint8_t* coverage, size_t count, uint32_t color)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i col = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)color), zero);
+    const __m256i spread = _mm256_set1_epi32(0x01010101);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint64_t c8;
+        memcpy(&c8, coverage + i, sizeof(c8));
+        if (!c8) continue;
+        const __m256i c = _mm256_mullo_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(coverage + i))), spread);
+        const __m256i lo = div255_avx2(_mm256_mullo_epi16(_mm256_unpacklo_epi8(c, zero), col));
+        const __m256i hi = div255_avx2(_mm256_mullo_epi16(_mm256_unpackhi_epi8(c, zero), col));
+        const __m256i v = _mm256_packus_epi16(lo, hi);
+        const __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_blendv_epi8(v, d, _mm256_cmpeq_epi8(c, zero)));
+    }
+    _mm256_zeroupper();
+    coverage_sse2(dst + i, coverage + i, count - i, color);
+}
+
+// Eight lanes of texel indices per step, fetched with one gather.
+CCE_AVX2 static void sample_avx2(uint32_t* dst, const uint32_t* src, size_t stride,
+                                 int32_t u, int32_t v, int32_t du, int32_t dv, size_t count)
+{
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i uu = _mm256_add_epi32(_mm256_set1_epi32(u), _mm256_mullo_epi32(lane, _mm256_set1_epi32(du)));
+    __m256i vv = _mm256_add_epi32(_mm256_set1_epi32(v), _mm256_mullo_epi32(lane, _mm256_set1_epi32(dv)));
+    const __m256i step_u = _mm256_set1_epi32(du * 8);
+    const __m256i step_v = _mm256_set1_epi32(dv * 8);
+    const __m256i row = _mm256_set1_epi32((int)stride);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i idx = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_srai_epi32(vv, 16), row), _mm256_srai_epi32(uu, 16));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_i32gather_epi32((const int*)(const void*)src, idx, 4));
+        uu = _mm256_add_epi32(uu, step_u);
+        vv = _mm256_add_epi32(vv, step_v);
+    }
+    _mm256_zeroupper();
+    sample_scalar(dst + i, src, stride, u + (int32_t)i * du, v + (int32_t)i * dv, du, dv, count - i);
+}
+
+CCE_AVX2 static uint64_t hash_avx2(const uint32_t* src, size_t count, uint64_t seed)
+{
+    uint32_t acc[CCE_HASH_LANES];
+    hash_lanes_init(acc, seed);
+    const __m256i p1 = _mm256_set1_epi32((int)CCE_HASH_P1);
+    const __m256i p2 = _mm256_set1_epi32((int)CCE_HASH_P2);
+    __m256i a[CCE_HASH_LANES / 8];
+    for (int v = 0; v < CCE_HASH_LANES / 8; v++) a[v] = _mm256_loadu_si256((const __m256i*)(acc + v * 8));
+    size_t i = 0;
+    for (; i + CCE_HASH_LANES <= count; i += CCE_HASH_LANES) {
+        for (int v = 0; v < CCE_HASH_LANES / 8; v++) {
+            __m256i x = _mm256_add_epi32(a[v], _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)(src + i + v * 8)), p2));
+            x = _mm256_or_si256(_mm256_slli_epi32(x, 13), _mm256_srli_epi32(x, 19));
+            a[v] = _mm256_mullo_epi32(x, p1);
+        }
+    }
+    for (int v = 0; v < CCE_HASH_LANES / 8; v++) _mm256_storeu_si256((__m256i*)(acc + v * 8), a[v]);
+    _mm256_zeroupper();
+    return hash_finish(acc, src + i, count - i, count);
+}
+
+// Eight cells per step; the palette entries are fetched with one gather.
+CCE_AVX2 static void palette_avx2(uint32_t* dst, const uint32_t* lut, uint32_t x, uint32_t y, uint32_t step,
+                                  uint32_t seed, size_t count)
+{
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const uint32_t as = step * 1836311903u;
+    const __m256i k = _mm256_set1_epi32((int)((y * 2971215073u) ^ (seed * 1073741827u)));
+    __m256i xa = _mm256_add_epi32(_mm256_set1_epi32((int)(x * 1836311903u)), _mm256_mullo_epi32(lane, _mm256_set1_epi32((int)as)));
+    const __m256i xstep = _mm256_set1_epi32((int)(8 * as));
+    const __m256i c60493 = _mm256_set1_epi32(60493);
+    const __m256i c19990303 = _mm256_set1_epi32(19990303);
+    const __m256i c1376312589 = _mm256_set1_epi32(1376312589);
+    const __m256i low31 = _mm256_set1_epi32(0x7FFFFFFF);
+    const __m256 inv31 = _mm256_set1_ps(0x1p-31f);
+    const __m256 c255 = _mm256_set1_ps(255.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i n = _mm256_xor_si256(xa, k);
+        n = _mm256_xor_si256(_mm256_srli_epi32(n, 13), n);
+        const __m256i inner = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_mullo_epi32(n, n), c60493), c19990303);
+        n = _mm256_add_epi32(_mm256_mullo_epi32(n, inner), c1376312589);
+        const __m256 f = _mm256_cvtepi32_ps(_mm256_and_si256(n, low31));
+        const __m256i idx = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_mul_ps(f, inv31), c255));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_i32gather_epi32((const int*)(const void*)lut, idx, 4));
+        xa = _mm256_add_epi32(xa, xstep);
+    }
+    _mm256_zeroupper();
+    palette_scalar(dst + i, lut, x + (uint32_t)i * step, y, step, seed, count - i);
+}
+
+CCE_AVX2 static inline __m256i noise_hash_avx2(__m256i xa, __m256i k)
+{
+    __m256i n = _mm256_xor_si256(xa, k);
+    n = _mm256_xor_si256(_mm256_srli_epi32(n, 13), n);
+    const __m256i inner = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_mullo_epi32(n, n), _mm256_set1_epi32(60493)), _mm256_set1_epi32(19990303));
+    return _mm256_add_epi32(_mm256_mullo_epi32(n, inner), _mm256_set1_epi32(1376312589));
+}
+
+CCE_AVX2 static inline __m256 noise_fade_avx2(__m256 t)
+{
+    __m256 p = _mm256_mul_ps(t, _mm256_set1_ps(6.0f));
+    p = _mm256_sub_ps(p, _mm256_set1_ps(15.0f));
+    p = _mm256_mul_ps(t, p);
+    p = _mm256_add_ps(p, _mm256_set1_ps(10.0f));
+    return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), p);
+}
+
+CCE_AVX2 static inline __m256 noise_lerp_avx2(__m256 a, __m256 b, __m256 t)
+{
+    return _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), t));
+}
+
+CCE_AVX2 static inline __m256 noise_corner_avx2(__m256i h, __m256 dx, __m256 dy, CCE_NoiseType type)
+{
+    if (type == CCE_NOISE_VALUE) {
+        const __m256 v = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(h, 8)), _mm256_set1_ps(0x1p-23f));
+        return _mm256_sub_ps(v, _mm256_set1_ps(1.0f));
+    }
+    const __m256i sx = _mm256_slli_epi32(_mm256_andnot_si256(h, _mm256_set1_epi32(1)), 31);
+    const __m256i sy = _mm256_slli_epi32(_mm256_andnot_si256(h, _mm256_set1_epi32(2)), 30);
+    return _mm256_add_ps(_mm256_xor_ps(dx, _mm256_castsi256_ps(sx)), _mm256_xor_ps(dy, _mm256_castsi256_ps(sy)));
+}
+
+CCE_AVX2 static void noise_avx2(float* dst, float x, float y, float frequency, uint32_t seed, CCE_NoiseType type, size_t count)
+{
+    const float py = y * frequency;
+    const float fy = floorf(py);
+    const uint32_t iy = (uint32_t)(int32_t)fy;
+    const __m256 ty = _mm256_set1_ps(py - fy);
+    const __m256 ty1 = _mm256_sub_ps(ty, _mm256_set1_ps(1.0f));
+    const __m256 v = noise_fade_avx2(ty);
+    const __m256i k0 = _mm256_set1_epi32((int)((iy * 2971215073u) ^ (seed * 1073741827u)));
+    const __m256i k1 = _mm256_set1_epi32((int)(((iy + 1u) * 2971215073u) ^ (seed * 1073741827u)));
+    const __m256i ax = _mm256_set1_epi32((int)1836311903u);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 fx0 = _mm256_set1_ps(x);
+    const __m256 freq = _mm256_set1_ps(frequency);
+    __m256 lane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 px = _mm256_mul_ps(_mm256_add_ps(fx0, lane), freq);
+        const __m256 fx = _mm256_floor_ps(px);
+        const __m256 tx = _mm256_sub_ps(px, fx);
+        const __m256 tx1 = _mm256_sub_ps(tx, one);
+        const __m256 u = noise_fade_avx2(tx);
+        const __m256i xa = _mm256_mullo_epi32(_mm256_cvttps_epi32(fx), ax);
+        const __m256i xa1 = _mm256_add_epi32(xa, ax);
+        const __m256 n00 = noise_corner_avx2(noise_hash_avx2(xa, k0), tx, ty, type);
+        const __m256 n10 = noise_corner_avx2(noise_hash_avx2(xa1, k0), tx1, ty, type);
+        const __m256 n01 = noise_corner_avx2(noise_hash_avx2(xa, k1), tx, ty1, type);
+        const __m256 n11 = noise_corner_avx2(noise_hash_avx2(xa1, k1), tx1, ty1, type);
+        _mm256_storeu_ps(dst + i, noise_lerp_avx2(noise_lerp_avx2(n00, n10, u), noise_lerp_avx2(n01, n11, u), v));
+        lane = _mm256_add_ps(lane, _mm256_set1_ps(8.0f));
+    }
+    _mm256_zeroupper();
+    noise_row_scalar(dst, x, y, frequency, seed, type, i, count);
+}
+
+static const CCE_KernelTable g_sse2_kernels = {
+    .name = "sse2",
+    .fill = fill_sse2,
+    .copy = copy_scalar,
+    .blend = blend_sse2,
+    .add = add_sse2,
+    .multiply = multiply_sse2,
+    .modulate = modulate_sse2,
+    .coverage = coverage_sse2,
+    .sample = sample_scalar, // no gather before AVX2
+    .palette = palette_sse2,
+    .noise = noise_sse2,
+    .hash = hash_sse2,
+};
+
+static const CCE_KernelTable g_avx2_kernels = {
+    .name = "avx2",
+    .fill = fill_avx2,
+    .copy = copy_scalar,
+    .blend = blend_avx2,
+    .add = add_avx2,
+    .multiply = multiply_avx2,
+    .modulate = modulate_avx2,
+    .coverage = coverage_avx2,
+    .sample = sample_avx2,
+    .palette = palette_avx2,
+    .noise = noise_avx2,
+    .hash = hash_avx2,
+};
+
+#elif defined(CCE_KERNEL_NEON)
+
+/* NEON: 4 pixels per step, channels widened to 16 bits */
+
+static inline uint16x8_t div255_neon(uint16x8_t x)
+{
+    x = vaddq_u16(x, vdupq_n_u16(1));
+    return vshrq_n_u16(vaddq_u16(x, vshrq_n_u16(x, 8)), 8);
+}
+
+static void fill_neon(uint32_t* dst, uint32_t value, size_t count)
+{
+    const uint32x4_t v = vdupq_n_u32(value);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        vst1q_u32(dst + i, v);
+        vst1q_u32(dst + i + 4, v);
+        vst1q_u32(dst + i + 8, v);
+        vst1q_u32(dst + i + 12, v);
+    }
+    for (; i + 4 <= count; i += 4) vst1q_u32(dst + i, v);
+    for (; i < count; i++) dst[i] = value;
+}
+
+static void blend_neon(uint32_t* dst, const uint32_t* src, size_t count)
+{
+    const uint8x16_t rgb_mask = vreinterpretq_u8_u32(vdupq_n_u32(0x00FFFFFFu));
+    const uint8x16_t alpha_one = vreinterpretq_u8_u32(vdupq_n_u32(0xFF000000u));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const uint8x16_t s = vld1q_u8((const uint8_t*)(src + i));
+        const uint8x16_t d = vld1q_u8((const uint8_t*)(dst + i));
+        const uint8x16_t a = vreinterpretq_u8_u32(vmulq_n_u32(vshrq_n_u32(vreinterpretq_u32_u8(s), 24), 0x01010101u));
+        // Source alpha lane is weighted by 255 so out.a = sa + da * (1 - sa).
+        const uint8x16_t sw = vorrq_u8(vandq_u8(a, rgb_mask), alpha_one);
+        const uint8x16_t ia = vmvnq_u8(a);
+        uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(s), vget_low_u8(sw)), vget_low_u8(d), vget_low_u8(ia));
+        uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(s), vget_high_u8(sw)), vget_high_u8(d), vget_high_u8(ia));
+        vst1q_u8((uint8_t*)(dst + i), vcombine_u8(vmovn_u16(div255_neon(lo)), vmovn_u16(div255_neon(hi))));
+    }
+    blend_scalar(dst + i, src + i, count - i);
+}
+
+static void add_neon(uint32_t* dst, const uint32_t* src, size_t count)
+{
+    const uint8x16_t rgb_mask = vreinterpretq_u8_u32(vdupq_n_u32(0x00FFFFFFu));
+    const uint8x16_t alpha_one = vreinterpretq_u8_u32(vdupq_n_u32(0xFF000000u));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const uint8x16_t s = vld1q_u8((const uint8_t*)(src + i));
+        const uint8x16_t a = vreinterpretq_u8_u32(vmulq_n_u32(vshrq_n_u32(vreinterpretq_u32_u8(s), 24), 0x01010101u));
+        const uint8x16_t sw = vorrq_u8(vandq_u8(a, rgb_mask), alpha_one);
+        const uint16x8_t lo = div255_neon(vmull_u8(vget_low_u8(s), vget_low_u8(sw)));
+        const uint16x8_t hi = div255_neon(vmull_u8(vget_high_u8(s), vget_high_u8(sw)));
+        const uint8x16_t d = vld1q_u8((const uint8_t*)(dst + i));
+        vst1q_u8((uint8_t*)(dst + i), vqaddq_u8(d, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi))));
+    }
+    add_scalar(dst + i, src + i, count - i);
+}
+
+static void multiply_neon(uint32_t* dst, const uint32_t* src, size_t count)
+{
+    const uint8x16_t rgb_mask = vreinterpretq_u8_u32(vdupq_n_u32(0x00FFFFFFu));
+    const uint8x16_t alpha_one = vreinterpretq_u8_u32(vdupq_n_u32(0xFF000000u));
+    const uint8x8_t c255 = vdup_n_u8(255);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const uint8x16_t s = vld1q_u8((const uint8_t*)(src + i));
+        const uint8x16_t a = vreinterpretq_u8_u32(vmulq_n_u32(vshrq_n_u32(vreinterpretq_u32_u8(s), 24), 0x01010101u));
+        const uint8x16_t ia = vmvnq_u8(a);
+        const uint16x8_t flo = div255_neon(vmlal_u8(vmull_u8(vget_low_u8(s), vget_low_u8(a)), c255, vget_low_u8(ia)));
+        const uint16x8_t fhi = div255_neon(vmlal_u8(vmull_u8(vget_high_u8(s), vget_high_u8(a)), c255, vget_high_u8(ia)));
+        // Alpha lane factor is 1 so dst alpha is kept.
+        const uint8x16_t f = vorrq_u8(vandq_u8(vcombine_u8(vmovn_u16(flo), vmovn_u16(fhi)), rgb_mask), alpha_one);
+        const uint8x16_t d = vld1q_u8((const uint8_t*)(dst + i));
+        const uint16x8_t lo = div255_neon(vmull_u8(vget_low_u8(d), vget_low_u8(f)));
+        const uint16x8_t hi = div255_neon(vmull_u8(vget_high_u8(d), vget_high_u8(f)));
+        vst1q_u8((uint8_t*)(dst + i), vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+    }
+    multiply_scalar(dst + i, src + i, count - i);
+}
+
+static void modulate_neon(uint32_t* dst, const uint32_t* src, size_t count, uint32_t tint)
+{
+    const uint8x8_t t = vreinterpret_u8_u32(vdup_n_u32(tint));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const uint8x16_t s = vld1q_u8((const uint8_t*)(src + i));
+        const uint16x8_t lo = div255_neon(vmull_u8(vget_low_u8(s), t));
+        const uint16x8_t hi = div255_neon(vmull_u8(vget_high_u8(s), t));
+        vst1q_u8((uint8_t*)(dst + i), vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+    }
+    modulate_scalar(dst + i, src + i, count - i, tint);
+}
+
+static void coverage_neon(uint32_t* dst, const uint8_t* coverage, size_t count, uint32_t color)
+{
+    const uint8x8_t col = vreinterpret_u8_u32(vdup_n_u32(color));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint32_t c4;
+        memcpy(&c4, coverage + i, sizeof(c4));
+        if (!c4) continue;
+        const uint32x4_t cw = vmovl_u16(vget_low_u16(vmovl_u8(vcreate_u8((uint64_t)c4))));
+        const uint8x16_t c = vreinterpretq_u8_u32(vmulq_n_u32(cw, 0x01010101u));
+        const uint16x8_t lo = div255_neon(vmull_u8(vget_low_u8(c), col));
+        const uint16x8_t hi = div255_neon(vmull_u8(vget_high_u8(c), col));
+        const uint8x16_t v = vcombine_u8(vmovn_u16(lo), vmovn_u16(hi));
+        const uint8x16_t d = vld1q_u8((const uint8_t*)(dst + i));
+        vst1q_u8((uint8_t*)(dst + i), vbslq_u8(vceqq_u8(c, vdupq_n_u8(0)), d, v));
+    }
+    coverage_scalar(dst + i, coverage + i, count - i, color);
+}
+
+static uint64_t hash_neon(const uint32_t* src, size_t count, uint64_t seed)
+{
+    uint32_t acc[CCE_HASH_LANES];
+    hash_lanes_init(acc, seed);
+    const uint32x4_t p1 = vdupq_n_u32(CCE_HASH_P1);
+    const uint32x4_t p2 = vdupq_n_u32(CCE_HASH_P2);
+    uint32x4_t a[CCE_HASH_LANES / 4];
+    for (int v = 0; v < CCE_HASH_LANES / 4; v++) a[v] = vld1q_u32(acc + v * 4);
+    size_t i = 0;
+    for (; i + CCE_HASH_LANES <= count; i += CCE_HASH_LANES) {
+        for (int v = 0; v < CCE_HASH_LANES / 4; v++) {
+            const uint32x4_t x = vmlaq_u32(a[v], vld1q_u32(src + i + v * 4), p2);
+            a[v] = vmulq_u32(vsriq_n_u32(vshlq_n_u32(x, 13), x, 19), p1);
+        }
+    }
+    for (int v = 0; v < CCE_HASH_LANES / 4; v++) vst1q_u32(acc + v * 4, a[v]);
+    return hash_finish(acc, src + i, count - i, count);
+}
+
+// Four cells per step; NEON has no gather, so the palette entries are read per lane.
+static void palette_neon(uint32_t* dst, const uint32_t* lut, uint32_t x, uint32_t y, uint32_t step,
+                         uint32_t seed, size_t count)
+{
+    const uint32_t ax = x * 1836311903u;
+    const uint32_t as = step * 1836311903u;
+    const uint32x4_t k = vdupq_n_u32((y * 2971215073u) ^ (seed * 1073741827u));
+    const uint32_t start[4] = { ax, ax + as, ax + 2 * as, ax + 3 * as };
+    uint32x4_t xa = vld1q_u32(start);
+    const uint32x4_t xstep = vdupq_n_u32(4 * as);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t n = veorq_u32(xa, k);
+        n = veorq_u32(vshrq_n_u32(n, 13), n);
+        const uint32x4_t inner = vmlaq_u32(vdupq_n_u32(19990303u), vmulq_u32(n, n), vdupq_n_u32(60493u));
+        n = vmlaq_u32(vdupq_n_u32(1376312589u), n, inner);
+        const float32x4_t f = vcvtq_f32_u32(vandq_u32(n, vdupq_n_u32(0x7FFFFFFFu)));
+        uint32_t idx[4];
+        vst1q_u32(idx, vcvtq_u32_f32(vmulq_n_f32(vmulq_n_f32(f, 0x1p-31f), 255.0f)));
+        dst[i + 0] = lut[idx[0]];
+        dst[i + 1] = lut[idx[1]];
+        dst[i + 2] = lut[idx[2]];
+        dst[i + 3] = lut[idx[3]];
+        xa = vaddq_u32(xa, xstep);
+    }
+    palette_scalar(dst + i, lut, x + (uint32_t)i * step, y, step, seed, count - i);
+}
+
+static inline uint32x4_t noise_hash_neon(uint32x4_t xa, uint32x4_t k)
+{
+    uint32x4_t n = veorq_u32(xa, k);
+    n = veorq_u32(vshrq_n_u32(n, 13), n);
+    const uint32x4_t inner = vaddq_u32(vmulq_u32(vmulq_u32(n, n), vdupq_n_u32(60493u)), vdupq_n_u32(19990303u));
+    return vaddq_u32(vmulq_u32(n, inner), vdupq_n_u32(1376312589u));
+}
+
+// Separate multiplies and adds (never vmla/vfma) keep the results equal to the scalar reference.
+static inline float32x4_t noise_fade_neon(float32x4_t t)
+{
+    float32x4_t p = vmulq_n_f32(t, 6.0f);
+    p = vsubq_f32(p, vdupq_n_f32(15.0f));
+    p = vmulq_f32(t, p);
+    p = vaddq_f32(p, vdupq_n_f32(10.0f));
+    return vmulq_f32(vmulq_f32(vmulq_f32(t, t), t), p);
+}
+
+static inline float32x4_t noise_lerp_neon(float32x4_t a, float32x4_t b, float32x4_t t)
+{
+    return vaddq_f32(a, vmulq_f32(vsubq_f32(b, a), t));
+}
+
+static inline float32x4_t noise_corner_neon(uint32x4_t h, float32x4_t dx, float32x4_t dy, CCE_NoiseType type)
+{
+    if (type == CCE_NOISE_VALUE) {
+        const float32x4_t v = vmulq_n_f32(vcvtq_f32_u32(vshrq_n_u32(h, 8)), 0x1p-23f);
+        return vsubq_f32(v, vdupq_n_f32(1.0f));
+    }
+    const uint32x4_t sx = vshlq_n_u32(vbicq_u32(vdupq_n_u32(1u), h), 31);
+    const uint32x4_t sy = vshlq_n_u32(vbicq_u32(vdupq_n_u32(2u), h), 30);
+    return vaddq_f32(vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(dx), sx)),
+                     vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(dy), sy)));
+}
+
+static void noise_neon(float* dst, float x, float y, float frequency, uint32_t seed, CCE_NoiseType type, size_t count)
+{
+    const float py = y * frequency;
+    const float fy = floorf(py);
+    const uint32_t iy = (uint32_t)(int32_t)fy;
+    const float32x4_t ty = vdupq_n_f32(py - fy);
+    const float32x4_t ty1 = vsubq_f32(ty, vdupq_n_f32(1.0f));
+    const float32x4_t v = noise_fade_neon(ty);
+    const uint32x4_t k0 = vdupq_n_u32((iy * 2971215073u) ^ (seed * 1073741827u));
+    const uint32x4_t k1 = vdupq_n_u32(((iy + 1u) * 2971215073u) ^ (seed * 1073741827u));
+    const uint32x4_t ax = vdupq_n_u32(1836311903u);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t fx0 = vdupq_n_f32(x);
+    const float lanes[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+    float32x4_t lane = vld1q_f32(lanes);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t px = vmulq_n_f32(vaddq_f32(fx0, lane), frequency);
+        // floor: truncate, then step down where that rounded up.
+        int32x4_t ix = vcvtq_s32_f32(px);
+        ix = vaddq_s32(ix, vreinterpretq_s32_u32(vcgtq_f32(vcvtq_f32_s32(ix), px)));
+        const float32x4_t tx = vsubq_f32(px, vcvtq_f32_s32(ix));
+        const float32x4_t tx1 = vsubq_f32(tx, one);
+        const float32x4_t u = noise_fade_neon(tx);
+        const uint32x4_t xa = vmulq_u32(vreinterpretq_u32_s32(ix), ax);
+        const uint32x4_t xa1 = vaddq_u32(xa, ax);
+        const float32x4_t n00 = noise_corner_neon(noise_hash_neon(xa, k0), tx, ty, type);
+        const float32x4_t n10 = noise_corner_neon(noise_hash_neon(xa1, k0), tx1, ty, type);
+        const float32x4_t n01 = noise_corner_neon(noise_hash_neon(xa, k1), tx, ty1, type);
+        const float32x4_t n11 = noise_corner_neon(noise_hash_neon(xa1, k1), tx1, ty1, type);
+        vst1q_f32(dst + i, noise_lerp_neon(noise_lerp_neon(n00, n10, u), noise_lerp_neon(n01, n11, u), v));
+        lane = vaddq_f32(lane, vdupq_n_f32(4.0f));
+    }
+    noise_row_scalar(dst, x, y, frequency, seed, type, i, count);
+}
+
+static const CCE_KernelTable g_neon_kernels = {
+    .name = "neon",
+    .fill = fill_neon,
+    .copy = copy_scalar,
+    .blend = blend_neon,
+    .add = add_neon,
+    .multiply = multiply_neon,
+    .modulate = modulate_neon,
+    .coverage = coverage_neon,
+    .sample = sample_scalar, // NEON has no gather
+    .palette = palette_neon,
+    .noise = noise_neon,
+    .hash = hash_neon,
+};
+
+#endif
+
+void cce_kernel_init(void)
+{
+    cce_kernels = cce_scalar_kernels;
+#if defined(CCE_KERNEL_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        cce_kernels = g_avx2_kernels;
+    } else if (__builtin_cpu_supports("sse2")) {
+        cce_kernels = g_sse2_kernels;
+    }
+#elif defined(CCE_KERNEL_NEON)
+    cce_kernels = g_neon_kernels;
+#endif
+    cce_printf("Pixel kernels: %s\n", cce_kernels.name);
+}
+
+const char* cce_get_kernel_isa(void)
+{
+    return cce_kernels.name;
+}
@@ -0,0 +1,171 @@
+/*
+===========================================================================
+MIT License
+
+Copyright (c) 2026 Stepan Pukhovskiy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+===========================================================================
+*/
+
+#ifndef CCE_KERNEL_GUARD_H
+#define CCE_KERNEL_GUARD_H
+
+#include "../engine.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Span kernels over packed RGBA8 pixels (one uint32_t per pixel, memory order r,g,b,a).
+// Channel products are divided by 255 with truncation, matching the scalar paths.
+typedef struct CCE_KernelTable
+{
+    const char* name;
+    // dst[i] = value
+    void (*fill)(uint32_t* dst, uint32_t value, size_t count);
+    // dst[i] = src[i]; spans must not overlap. memcpy on every ISA.
+    void (*copy)(uint32_t* dst, const uint32_t* src, size_t count);
+    // Source-over with straight alpha: dst = src * a + dst * (1 - a).
+    void (*blend)(uint32_t* dst, const uint32_t* src, size_t count);
+    // Additive: dst.rgb += src.rgb * a, dst.a += a, saturating.
+    void (*add)(uint32_t* dst, const uint32_t* src, size_t count);
+    // Multiply: dst.rgb *= src.rgb faded towards white by (1 - a); dst.a is kept.
+    void (*multiply)(uint32_t* dst, const uint32_t* src, size_t count);
+    // dst[i] = src[i] * tint per channel; dst may equal src.
+    void (*modulate)(uint32_t* dst, const uint32_t* src, size_t count, uint32_t tint);
+    // dst[i] = color * coverage[i] per channel where coverage[i] > 0, untouched otherwise.
+    void (*coverage)(uint32_t* dst, const uint8_t* coverage, size_t count, uint32_t color);
+    // Nearest-neighbour affine fetch in 16.16 fixed point: dst[i] = src[(v >> 16) * stride + (u >> 16)],
+    // stepping u by du and v by dv per pixel. Every sample must fall inside src.
+    void (*sample)(uint32_t* dst, const uint32_t* src, size_t stride, int32_t u, int32_t v, int32_t du, int32_t dv, size_t count);
+    // Noise palette lookup: dst[i] = lut[cce_noise_byte(x + i * step, y, seed)].
+    void (*palette)(uint32_t* dst, const uint32_t* lut, uint32_t x, uint32_t y, uint32_t step, uint32_t seed, size_t count);
+    // One octave of lattice noise in [-1, 1]: dst[i] = noise((x + i) * frequency, y * frequency).
+    // Every ISA returns the same bits as the scalar reference.
+    void (*noise)(float* dst, float x, float y, float frequency, uint32_t seed, CCE_NoiseType type, size_t count);
+    // 64-bit content hash (eight xxHash32-style lanes folded together); same value on every ISA.
+    uint64_t (*hash)(const uint32_t* src, size_t count, uint64_t seed);
+} CCE_KernelTable;
+
+// Active kernel set; starts as scalar and is switched by cce_kernel_init().
+extern CCE_KernelTable cce_kernels;
+// Scalar reference set every ISA must match bit for bit; examples/test-kernels times against it.
+extern const CCE_KernelTable cce_scalar_kernels;
+
+// Picks the widest kernel set the running CPU supports. Called from cce_engine_init().
+void cce_kernel_init(void);
+
+// Exact floor(x / 255) for x <= 255 * 255.
+static inline uint32_t cce_div255(uint32_t x)
+{
+    x += 1;
+    return (x + (x >> 8)) >> 8;
+}
+
+// Integer lattice hash behind procedural_noise(); the palette kernels repeat it per lane.
+static inline uint32_t cce_noise_hash(uint32_t x, uint32_t y, uint32_t seed)
+{
+    uint32_t n = (x * 1836311903u) ^ (y * 2971215073u) ^ (seed * 1073741827u);
+    n = (n >> 13) ^ n;
+    return n * (n * n * 60493u + 19990303u) + 1376312589u;
+}
+
+// procedural_noise() scaled to 0..255 and truncated, the way the noise palettes read it.
+static inline uint32_t cce_noise_byte(uint32_t x, uint32_t y, uint32_t seed)
+{
+    return (uint32_t)((float)(cce_noise_hash(x, y, seed) & 0x7FFFFFFFu) / 2147483647.0f * 255.0f);
+}
+
+static inline uint32_t cce_channel(uint32_t p, int shift)
+{
+    return (p >> shift) & 0xFFu;
+}
+
+// Single-pixel forms of the blend kernels; the scalar kernels are built on these.
+static inline uint32_t cce_pixel_over(uint32_t s, uint32_t d)
+{
+    const uint32_t sa = s >> 24;
+    if (sa == 255) return s;
+    if (sa == 0) return d;
+    const uint32_t ia = 255 - sa;
+    uint32_t out = 0;
+    for (int sh = 0; sh < 24; sh += 8) {
+        out |= cce_div255(cce_channel(s, sh) * sa + cce_channel(d, sh) * ia) << sh;
+    }
+    out |= cce_div255(sa * 255 + (d >> 24) * ia) << 24;
+    return out;
+}
+
+static inline uint32_t cce_pixel_add(uint32_t s, uint32_t d)
+{
+    const uint32_t sa = s >> 24;
+    if (sa == 0) return d;
+    uint32_t out = 0;
+    for (int sh = 0; sh < 24; sh += 8) {
+        const uint32_t c = cce_channel(d, sh) + cce_div255(cce_channel(s, sh) * sa);
+        out |= (c > 255 ? 255 : c) << sh;
+    }
+    const uint32_t a = (d >> 24) + sa;
+    return out | (a > 255 ? 255 : a) << 24;
+}
+
+static inline uint32_t cce_pixel_multiply(uint32_t s, uint32_t d)
+{
+    const uint32_t sa = s >> 24;
+    if (sa == 0) return d;
+    const uint32_t ia = 255 - sa;
+    uint32_t out = d & 0xFF000000u;
+    for (int sh = 0; sh < 24; sh += 8) {
+        // Factor fades from 1 to the source channel as alpha rises.
+        const uint32_t f = cce_div255(cce_channel(s, sh) * sa + 255 * ia);
+        out |= cce_div255(cce_channel(d, sh) * f) << sh;
+    }
+    return out;
+}
+
+static inline uint32_t cce_blend_pixel(CCE_BlendMode mode, uint32_t s, uint32_t d)
+{
+    switch (mode) {
+        case CCE_BLEND_ALPHA: return cce_pixel_over(s, d);
+        case CCE_BLEND_ADD: return cce_pixel_add(s, d);
+        case CCE_BLEND_MULTIPLY: return cce_pixel_multiply(s, d);
+        default: return s;
+    }
+}
+
+// Writes src over dst with one of the layer blend modes.
+static inline void cce_blend_span(CCE_BlendMode mode, uint32_t* dst, const uint32_t* src, size_t count)
+{
+    switch (mode) {
+        case CCE_BLEND_ALPHA: cce_kernels.blend(dst, src, count); break;
+        case CCE_BLEND_ADD: cce_kernels.add(dst, src, count); break;
+        case CCE_BLEND_MULTIPLY: cce_kernels.multiply(dst, src, count); break;
+        default: cce_kernels.copy(dst, src, count); break;
+    }
+}
+
+static inline uint32_t cce_pack_color(CCE_Color c)
+{
+    return ((uint32_t)c.r) |
+           ((uint32_t)c.g << 8) |
+           ((uint32_t)c.b << 16) |
+           ((uint32_t)c.a << 24);
+}
+
+#endif
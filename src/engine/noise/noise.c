@@ -0,0 +1,203 @@
+/*
+===========================================================================
+MIT License
+
+Copyright (c) 2026 Stepan Pukhovskiy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+===========================================================================
+*/
+
+#include "noise.h"
+#include "../engine.h"
+#include "../kernel/kernel.h"
+#include "../thread/thread.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Below this many pixels a fill stays on the calling thread.
+#define CCE_NOISE_PARALLEL_MIN_PIXELS (64 * 1024)
+
+CCE_Noise cce_noise_make(CCE_NoiseType type, CCE_NoiseFractal fractal, RandPackIndex slot)
+{
+    const CCE_Noise noise = {
+        .type = type,
+        .fractal = fractal,
+        .seed = (uint32_t)engine_seed ^ ((uint32_t)get_randpack_value(slot) * 2654435761u),
+        .frequency = 1.0f / 64.0f,
+        .octaves = 4,
+        .lacunarity = 2.0f,
+        .gain = 0.5f,
+    };
+    return noise;
+}
+
+static int noise_valid(const CCE_Noise* noise)
+{
+    if (!noise) return 0;
+    if (noise->type != CCE_NOISE_VALUE && noise->type != CCE_NOISE_PERLIN) return 0;
+    if (noise->fractal != CCE_NOISE_FBM && noise->fractal != CCE_NOISE_RIDGED) return 0;
+    if (noise->octaves < 1 || noise->octaves > CCE_NOISE_MAX_OCTAVES) return 0;
+    return noise->frequency > 0.0f && noise->gain > 0.0f;
+}
+
+void cce_noise_row(const CCE_Noise* noise, float* out, float* scratch, float x, float y, size_t count)
+{
+    float frequency = noise->frequency;
+    float amplitude = 1.0f;
+    float total = 0.0f;
+    for (size_t i = 0; i < count; i++) out[i] = 0.0f;
+
+    // Sums are kept one operation per statement so results do not depend on FMA contraction.
+    for (int o = 0; o < noise->octaves; o++) {
+        // Each octave gets its own lattice so their features do not line up.
+        const uint32_t seed = noise->seed + (uint32_t)o * 0x9E3779B9u;
+        cce_kernels.noise(scratch, x, y, frequency, seed, noise->type, count);
+        if (noise->fractal == CCE_NOISE_RIDGED) {
+            for (size_t i = 0; i < count; i++) {
+                float r = 1.0f - fabsf(scratch[i]);
+                r = r * r;
+                const float w = amplitude * r;
+                out[i] = out[i] + w;
+            }
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                const float w = amplitude * scratch[i];
+                out[i] = out[i] + w;
+            }
+        }
+        total += amplitude;
+        amplitude *= noise->gain;
+        frequency *= noise->lacunarity;
+    }
+
+    // fBm sums lie in [-total, total], ridged sums in [0, total].
+    const float scale = 1.0f / total;
+    const int fbm = noise->fractal == CCE_NOISE_FBM;
+    for (size_t i = 0; i < count; i++) {
+        float v = out[i] * scale;
+        if (fbm) {
+            v = v * 0.5f;
+            v = v + 0.5f;
+        }
+        out[i] = v < 0.0f ? 0.0f : v > 1.0f ? 1.0f : v;
+    }
+}
+
+float cce_noise_sample(const CCE_Noise* noise, float x, float y)
+{
+    if (!noise_valid(noise)) {
+        ERRLOG;
+        return 0.0f;
+    }
+    float out, scratch;
+    cce_noise_row(noise, &out, &scratch, x, y, 1);
+    return out;
+}
+
+typedef struct
+{
+    const CCE_Noise* noise;
+    float* out;
+    float* scratch;     // w floats per band
+    int stride;
+    int x, y, w, h;
+    int band;           // rows per job
+} CCE_NoiseFillWork;
+
+static void noise_band_job(int index, void* userdata)
+{
+    const CCE_NoiseFillWork* work = userdata;
+    const int row0 = index * work->band;
+    const int row1 = row0 + work->band < work->h ? row0 + work->band : work->h;
+    float* scratch = work->scratch + (size_t)index * (size_t)work->w;
+    for (int r = row0; r < row1; r++) {
+        cce_noise_row(work->noise, work->out + (size_t)r * (size_t)work->stride, scratch,
+                      (float)work->x, (float)(work->y + r), (size_t)work->w);
+    }
+}
+
+int cce_noise_fill(const CCE_Noise* noise, float* out, int stride, int x, int y, int w, int h)
+{
+    if (!noise_valid(noise) || !out || w < 0 || h < 0 || stride < w) {
+        ERRLOG;
+        return -1;
+    }
+    if (w == 0 || h == 0) return 0;
+
+    // One band per chunk row, so the work splits the same way as the layer fills.
+    const int band = engine_chunk_size;
+    const int bands = (h + band - 1) / band;
+    float* scratch = malloc((size_t)bands * (size_t)w * sizeof(float));
+    if (!scratch) {
+        ERRLOG;
+        return -1;
+    }
+
+    CCE_NoiseFillWork work = {
+        .noise = noise,
+        .out = out,
+        .scratch = scratch,
+        .stride = stride,
+        .x = x, .y = y, .w = w, .h = h,
+        .band = band,
+    };
+    if ((long)w * (long)h >= CCE_NOISE_PARALLEL_MIN_PIXELS) {
+        cce_parallel_for(bands, noise_band_job, &work);
+    } else {
+        for (int i = 0; i < bands; i++) noise_band_job(i, &work);
+    }
+    free(scratch);
+    return 0;
+}
+
+CCE_NoiseField* cce_noise_field_create(const CCE_Noise* noise, int x, int y, int w, int h)
+{
+    if (w < 1 || h < 1) {
+        ERRLOG;
+        return NULL;
+    }
+    CCE_NoiseField* field = malloc(sizeof(CCE_NoiseField));
+    float* values = malloc((size_t)w * (size_t)h * sizeof(float));
+    if (!field || !values) {
+        free(field);
+        free(values);
+        ERRLOG;
+        return NULL;
+    }
+    field->x = x;
+    field->y = y;
+    field->w = w;
+    field->h = h;
+    field->values = values;
+    if (cce_noise_fill(noise, values, w, x, y, w, h) != 0) {
+        cce_noise_field_free(field);
+        return NULL;
+    }
+    return field;
+}
+
+void cce_noise_field_free(CCE_NoiseField* field)
+{
+    if (!field) return;
+    free(field->values);
+    free(field);
+}
@@ -0,0 +1,610 @@
+/*
+===========================================================================
+MIT License
+
+Copyright (c) 2026 Stepan Pukhovskiy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+===========================================================================
+*/
+
+#include "raster.h"
+#include "../engine.h"
+#include "../kernel/kernel.h"
+#include "../render/render.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+
+// Span list a primitive is scan-converted into; rows outside the layer are dropped on push.
+typedef struct
+{
+    CCE_Span* spans;
+    size_t count, cap;
+    int w, h;
+    int failed;
+} SpanList;
+
+// Scratch reused between calls (drawing happens on the GL thread).
+static SpanList g_list;
+static double* g_cross = NULL;
+static int g_cross_cap = 0;
+
+static SpanList* span_begin(const CCE_Layer* layer)
+{
+    g_list.count = 0;
+    g_list.w = layer->scr_w;
+    g_list.h = layer->scr_h;
+    g_list.failed = 0;
+    return &g_list;
+}
+
+static void span_push(SpanList* list, int y, int x0, int x1)
+{
+    if (y < 0 || y >= list->h) return;
+    if (x0 < 0) x0 = 0;
+    if (x1 >= list->w) x1 = list->w - 1;
+    if (x0 > x1 || list->failed) return;
+    if (list->count == list->cap) {
+        const size_t cap = list->cap ? list->cap * 2 : 256;
+        CCE_Span* spans = realloc(list->spans, cap * sizeof(CCE_Span));
+        if (!spans) {
+            ERRLOG;
+            list->failed = 1;
+            return;
+        }
+        list->spans = spans;
+        list->cap = cap;
+    }
+    list->spans[list->count++] = (CCE_Span){ y, x0, x1 };
+}
+
+static int span_end(CCE_Layer* layer, SpanList* list, CCE_Color color)
+{
+    if (list->failed) return -1;
+    cce_raster_fill_spans(layer, list->spans, list->count, color);
+    return 0;
+}
+
+void cce_raster_fill_spans(CCE_Layer* layer, const CCE_Span* spans, size_t count, CCE_Color color)
+{
+    if (!layer || count == 0) return;
+    if (layer->backend == CCE_LAYER_GPU) {
+        for (size_t i = 0; i < count; i++) {
+            cce_set_pixel_rect(layer, spans[i].x0, spans[i].y, spans[i].x1, spans[i].y, color);
+        }
+        return;
+    }
+
+    const uint32_t packed = cce_pack_color(color);
+    const CCE_BlendMode mode = cce_solid_blend_mode(layer, packed);
+    // Zero alpha leaves every blend mode's destination as it was.
+    if (mode != CCE_BLEND_REPLACE && (packed >> 24) == 0) return;
+    uint32_t src[CCE_CHUNK_SIZE_MAX];
+    if (mode != CCE_BLEND_REPLACE) cce_kernels.fill(src, packed, (size_t)layer->chunk_size);
+
+    size_t band = 0;
+    while (band < count) {
+        // Spans of one chunk row, then every chunk they reach, one at a time.
+        const int cy = cce_chunk_index(layer, spans[band].y);
+        int xmin = INT_MAX, xmax = -1;
+        size_t end = band;
+        while (end < count && cce_chunk_index(layer, spans[end].y) == cy) {
+            if (spans[end].x0 < xmin) xmin = spans[end].x0;
+            if (spans[end].x1 > xmax) xmax = spans[end].x1;
+            end++;
+        }
+
+        const int cx1 = cce_chunk_index(layer, xmax);
+        for (int cx = cce_chunk_index(layer, xmin); cx <= cx1; cx++) {
+            CCE_Chunk* chunk = cce_layer_chunk(layer, cx, cy);
+            const int sx = cx * layer->chunk_size;
+            const int sy = cy * layer->chunk_size;
+
+            // Spans never overlap, so covering every pixel means the chunk can stay (or become) uniform.
+            long covered = 0;
+            for (size_t i = band; i < end; i++) {
+                const int lx0 = spans[i].x0 > sx ? spans[i].x0 - sx : 0;
+                const int lx1 = spans[i].x1 - sx < chunk->w ? spans[i].x1 - sx : chunk->w - 1;
+                if (lx0 <= lx1) covered += lx1 - lx0 + 1;
+            }
+            if (covered == (long)chunk->w * chunk->h && (mode == CCE_BLEND_REPLACE || chunk->uniform)) {
+                const uint32_t out = cce_blend_pixel(mode, packed, cce_pack_color(chunk->fill));
+                CCE_Color fill;
+                memcpy(&fill, &out, sizeof(fill));
+                cce_chunk_set_uniform(layer, chunk, fill);
+                continue;
+            }
+
+            int dx0 = chunk->w, dy0 = chunk->h, dx1 = -1, dy1 = -1;
+            for (size_t i = band; i < end; i++) {
+                const int lx0 = spans[i].x0 > sx ? spans[i].x0 - sx : 0;
+                const int lx1 = spans[i].x1 - sx < chunk->w ? spans[i].x1 - sx : chunk->w - 1;
+                if (lx0 > lx1) continue;
+                if (chunk->uniform) {
+                    const uint32_t fill = cce_pack_color(chunk->fill);
+                    if (cce_blend_pixel(mode, packed, fill) == fill) continue;
+                }
+                cce_chunk_materialize(layer, chunk);
+                const int ly = spans[i].y - sy;
+                uint32_t* dst = (uint32_t*)(void*)chunk->data + (size_t)ly * (size_t)chunk->w + (size_t)lx0;
+                const size_t n = (size_t)(lx1 - lx0 + 1);
+                if (mode == CCE_BLEND_REPLACE) cce_kernels.fill(dst, packed, n);
+                else cce_blend_span(mode, dst, src, n);
+                if (lx0 < dx0) dx0 = lx0;
+                if (lx1 > dx1) dx1 = lx1;
+                if (ly < dy0) dy0 = ly;
+                if (ly > dy1) dy1 = ly;
+            }
+            if (dx1 >= 0) cce_chunk_mark_dirty(layer, chunk, dx0, dy0, dx1, dy1);
+        }
+        band = end;
+    }
+}
+
+// Minor-axis offset of Bresenham step n for a segment with |major| >= |minor| deltas:
+// floor((2 * minor * n + major - 1) / (2 * major)), the pixel the error-term walk lands on.
+static int64_t line_minor(int64_t major, int64_t minor, int64_t n)
+{
+    return (int64_t)(((__int128)2 * minor * n + major - 1) / ((__int128)2 * major));
+}
+
+// Smallest step in [0, steps] whose minor offset reaches `target`, or steps + 1 if none does.
+static int64_t line_first(int64_t major, int64_t minor, int64_t steps, int64_t target)
+{
+    int64_t lo = 0, hi = steps + 1;
+    while (lo < hi) {
+        const int64_t mid = lo + (hi - lo) / 2;
+        if (line_minor(major, minor, mid) >= target) hi = mid;
+        else lo = mid + 1;
+    }
+    return lo;
+}
+
+// Step range [*lo, *hi] whose position `start + dir * offset` lies in [0, size); offsets rise with the step.
+static void line_clip(int64_t major, int64_t minor, int64_t steps, int64_t start, int dir, int size,
+                      int64_t* lo, int64_t* hi)
+{
+    const int64_t near = dir > 0 ? -start : start - (size - 1);
+    const int64_t far = dir > 0 ? size - 1 - start : start;
+    const int64_t first = line_first(major, minor, steps, near);
+    const int64_t last = line_first(major, minor, steps, far + 1) - 1;
+    if (first > *lo) *lo = first;
+    if (last < *hi) *hi = last;
+}
+
+// Bresenham, clipped to the layer before the walk: each pixel is a closed-form function of its
+// major-axis step, so only the visible steps are visited. Each row's run becomes one span.
+static void line_spans(SpanList* list, int x0, int y0, int x1, int y1)
+{
+    if (y0 > y1) {
+        int t = x0; x0 = x1; x1 = t;
+        t = y0; y0 = y1; y1 = t;
+    }
+    const int64_t dx = llabs((int64_t)x1 - x0), dy = (int64_t)y1 - y0;
+    const int sx = x0 < x1 ? 1 : -1;
+    if (dx == 0 && dy == 0) {
+        span_push(list, y0, x0, x0);
+        return;
+    }
+
+    int64_t lo = 0, hi;
+    if (dx >= dy) {
+        // One pixel per column; the steps of the visible columns and rows.
+        hi = dx;
+        line_clip(dx, dx, dx, x0, sx, list->w, &lo, &hi);
+        line_clip(dx, dy, dx, y0, 1, list->h, &lo, &hi);
+        int64_t run = lo;
+        for (int64_t n = lo; n <= hi; n++) {
+            const int64_t y = y0 + line_minor(dx, dy, n);
+            if (n == hi || y0 + line_minor(dx, dy, n + 1) != y) {
+                const int64_t a = x0 + sx * run, b = x0 + sx * n;
+                span_push(list, (int)y, (int)(a < b ? a : b), (int)(a < b ? b : a));
+                run = n + 1;
+            }
+        }
+    } else {
+        // One pixel per row.
+        hi = dy;
+        line_clip(dy, dy, dy, y0, 1, list->h, &lo, &hi);
+        line_clip(dy, dx, dy, x0, sx, list->w, &lo, &hi);
+        for (int64_t n = lo; n <= hi; n++) {
+            const int x = (int)(x0 + sx * line_minor(dy, dx, n));
+            span_push(list, (int)(y0 + n), x, x);
+        }
+    }
+}
+
+// Even-odd scan conversion sampled at pixel centres; vertices are in pixel-corner coordinates.
+static void polygon_spans(SpanList* list, const double* xs, const double* ys, int n)
+{
+    if (n > g_cross_cap) {
+        double* cross = realloc(g_cross, (size_t)n * sizeof(double));
+        if (!cross) {
+            ERRLOG;
+            list->failed = 1;
+            return;
+        }
+        g_cross = cross;
+        g_cross_cap = n;
+    }
+
+    double ymin = ys[0], ymax = ys[0];
+    for (int i = 1; i < n; i++) {
+        if (ys[i] < ymin) ymin = ys[i];
+        if (ys[i] > ymax) ymax = ys[i];
+    }
+    // Rows whose centre y + 0.5 lies in [ymin, ymax).
+    double row0 = ceil(ymin - 0.5), row1 = ceil(ymax - 0.5) - 1.0;
+    if (row0 < 0.0) row0 = 0.0;
+    if (row1 > (double)(list->h - 1)) row1 = (double)(list->h - 1);
+
+    for (int y = (int)row0; y <= (int)row1; y++) {
+        const double yc = (double)y + 0.5;
+        int k = 0;
+        for (int i = 0, j = n - 1; i < n; j = i++) {
+            // Half-open test so a vertex on the scanline is counted once.
+            if ((ys[i] <= yc) == (ys[j] <= yc)) continue;
+            const double x = xs[j] + (yc - ys[j]) * (xs[i] - xs[j]) / (ys[i] - ys[j]);
+            int m = k++;
+            while (m > 0 && g_cross[m - 1] > x) {
+                g_cross[m] = g_cross[m - 1];
+                m--;
+            }
+            g_cross[m] = x;
+        }
+        for (int i = 0; i + 1 < k; i += 2) {
+            // Pixels whose centre lies in [a, b).
+            double a = ceil(g_cross[i] - 0.5), b = ceil(g_cross[i + 1] - 0.5) - 1.0;
+            if (a < 0.0) a = 0.0;
+            if (b > (double)(list->w - 1)) b = (double)(list->w - 1);
+            if (a <= b) span_push(list, y, (int)a, (int)b);
+        }
+    }
+}
+
+// Exact ellipse test in 128-bit integers; every term fits for any int radii.
+typedef struct
+{
+    int64_t rx, ry;
+    __int128 a2, b2, limit;
+} EllipseFit;
+
+static EllipseFit ellipse_fit(int rx, int ry)
+{
+    EllipseFit e;
+    e.rx = rx;
+    e.ry = ry;
+    e.a2 = (__int128)rx * rx;
+    e.b2 = (__int128)ry * ry;
+    e.limit = e.a2 * e.b2 + (__int128)rx * ry * (rx < ry ? rx : ry);
+    return e;
+}
+
+// Half-width of row dy out from the centre, or -1 past ry: the largest x with
+// x^2*ry^2 + dy^2*rx^2 <= rx^2*ry^2 + rx*ry*min(rx, ry), which is the midpoint circle's
+// x^2 + dy^2 <= r^2 + r when rx == ry. A double square root is corrected to the exact value.
+static int64_t ellipse_width(const EllipseFit* e, int64_t dy)
+{
+    if (dy > e->ry) return -1;
+    if (e->b2 == 0) return e->rx;
+    const __int128 rest = e->limit - (__int128)dy * dy * e->a2;
+    int64_t x = (int64_t)sqrt((double)rest / (double)e->b2);
+    if (x > e->rx) x = e->rx;
+    while (x > 0 && (__int128)x * x * e->b2 > rest) x--;
+    while (x < e->rx && (__int128)(x + 1) * (x + 1) * e->b2 <= rest) x++;
+    return x;
+}
+
+// Span end clamped to one pixel past the layer, which clips the same but always fits an int.
+static int ellipse_edge(const SpanList* list, int64_t x)
+{
+    return x < -1 ? -1 : x > list->w ? list->w : (int)x;
+}
+
+static void ellipse_row(SpanList* list, int cx, int64_t y, const EllipseFit* e, int64_t dy, int filled)
+{
+    const int64_t w = ellipse_width(e, dy);
+    const int64_t next = ellipse_width(e, dy + 1);
+    const int64_t inner = next + 1 < w ? next + 1 : w;
+    if (filled || inner == 0) {
+        span_push(list, (int)y, ellipse_edge(list, cx - w), ellipse_edge(list, cx + w));
+    } else {
+        span_push(list, (int)y, ellipse_edge(list, cx - w), ellipse_edge(list, cx - inner));
+        span_push(list, (int)y, ellipse_edge(list, cx + inner), ellipse_edge(list, cx + w));
+    }
+}
+
+static int ellipse(CCE_Layer* layer, int cx, int cy, int rx, int ry, CCE_Color color, int filled)
+{
+    if (!layer || rx < 0 || ry < 0) {
+        ERRLOG;
+        return -1;
+    }
+    SpanList* list = span_begin(layer);
+    const EllipseFit e = ellipse_fit(rx, ry);
+    const int64_t h = list->h;
+
+    // Only rows on the layer are evaluated, top half then bottom half so spans stay sorted by y.
+    // The outline keeps the pixels of each row that the next row outwards does not cover,
+    // which leaves an 8-connected ring one pixel thick.
+    int64_t hi = cy < ry ? cy : ry;
+    for (int64_t dy = hi; dy >= 0 && cy - dy < h; dy--) {
+        ellipse_row(list, cx, cy - dy, &e, dy, filled);
+    }
+    hi = h - 1 - (int64_t)cy < ry ? h - 1 - (int64_t)cy : ry;
+    for (int64_t dy = -(int64_t)cy > 1 ? -(int64_t)cy : 1; dy <= hi; dy++) {
+        ellipse_row(list, cx, cy + dy, &e, dy, filled);
+    }
+    return span_end(layer, list, color);
+}
+
+int cce_draw_line(CCE_Layer* layer, int x0, int y0, int x1, int y1, CCE_Color color)
+{
+    if (!layer) {
+        ERRLOG;
+        return -1;
+    }
+    SpanList* list = span_begin(layer);
+    line_spans(list, x0, y0, x1, y1);
+    return span_end(layer, list, color);
+}
+
+int cce_draw_line_thick(CCE_Layer* layer, int x0, int y0, int x1, int y1, float thickness, CCE_Color color)
+{
+    if (!layer || !(thickness > 0.0f)) {
+        ERRLOG;
+        return -1;
+    }
+    if (thickness <= 1.0f) return cce_draw_line(layer, x0, y0, x1, y1, color);
+
+    // A quad around the centre line, stretched half a pixel past both endpoints so they are covered.
+    const double half = (double)thickness * 0.5;
+    double dx = (double)(x1 - x0), dy = (double)(y1 - y0);
+    const double len = sqrt(dx * dx + dy * dy);
+    if (len > 0.0) {
+        dx /= len;
+        dy /= len;
+    } else {
+        dx = 1.0;
+        dy = 0.0;
+    }
+    const double ex = dx * (len > 0.0 ? 0.5 : half), ey = dy * (len > 0.0 ? 0.5 : half);
+    const double nx = -dy * half, ny = dx * half;
+    const double ax = x0 + 0.5 - ex, ay = y0 + 0.5 - ey;
+    const double bx = x1 + 0.5 + ex, by = y1 + 0.5 + ey;
+    const double xs[4] = { ax + nx, bx + nx, bx - nx, ax - nx };
+    const double ys[4] = { ay + ny, by + ny, by - ny, ay - ny };
+
+    SpanList* list = span_begin(layer);
+    polygon_spans(list, xs, ys, 4);
+    return span_end(layer, list, color);
+}
+
+int cce_draw_circle(CCE_Layer* layer, int cx, int cy, int radius, CCE_Color color)
+{
+    return ellipse(layer, cx, cy, radius, radius, color, 0);
+}
+
+int cce_fill_circle(CCE_Layer* layer, int cx, int cy, int radius, CCE_Color color)
+{
+    return ellipse(layer, cx, cy, radius, radius, color, 1);
+}
+
+int cce_draw_ellipse(CCE_Layer* layer, int cx, int cy, int rx, int ry, CCE_Color color)
+{
+    return ellipse(layer, cx, cy, rx, ry, color, 0);
+}
+
+int cce_fill_ellipse(CCE_Layer* layer, int cx, int cy, int rx, int ry, CCE_Color color)
+{
+    return ellipse(layer, cx, cy, rx, ry, color, 1);
+}
+
+int cce_fill_polygon(CCE_Layer* layer, const CCE_Point* points, int count, CCE_Color color)
+{
+    if (!layer || !points || count < 3) {
+        ERRLOG;
+        return -1;
+    }
+    double* xy = malloc((size_t)count * 2 * sizeof(double));
+    if (!xy) {
+        ERRLOG;
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        xy[i] = (double)points[i].x;
+        xy[count + i] = (double)points[i].y;
+    }
+    SpanList* list = span_begin(layer);
+    polygon_spans(list, xy, xy + count, count);
+    free(xy);
+    return span_end(layer, list, color);
+}
+
+// Seed colour and per-channel tolerance a flood fill spreads through.
+typedef struct
+{
+    uint32_t seed;
+    int tolerance;
+} FloodKey;
+
+static inline int flood_match(uint32_t p, const FloodKey* key)
+{
+    if (p == key->seed) return 1;
+    if (key->tolerance == 0) return 0;
+    for (int sh = 0; sh < 32; sh += 8) {
+        const int d = (int)cce_channel(p, sh) - (int)cce_channel(key->seed, sh);
+        if (d > key->tolerance || -d > key->tolerance) return 0;
+    }
+    return 1;
+}
+
+// Walks row y from x in steps of dir while pixels match the key (want = 1) or do not (want = 0).
+// Returns the first x where that stops, or `stop` (exclusive) if the walk gets there first.
+// Uniform chunks are crossed in one step.
+static int flood_scan(const CCE_Layer* layer, int x, int y, int dir, int stop, int want, const FloodKey* key)
+{
+    const int cy = cce_chunk_index(layer, y);
+    const int ly = cce_chunk_local(layer, y);
+    while (x != stop) {
+        const int cx = cce_chunk_index(layer, x);
+        const CCE_Chunk* chunk = cce_layer_chunk(layer, cx, cy);
+        const int sx = cx * layer->chunk_size;
+        int end = dir > 0 ? sx + chunk->w : sx - 1;
+        if (dir > 0 ? end > stop : end < stop) end = stop;
+        if (chunk->uniform) {
+            if (flood_match(cce_pack_color(chunk->fill), key) != want) return x;
+            x = end;
+            continue;
+        }
+        const uint32_t* row = (const uint32_t*)(const void*)chunk->data + (size_t)ly * (size_t)chunk->w - sx;
+        for (; x != end; x += dir) {
+            if (flood_match(row[x], key) != want) return x;
+        }
+    }
+    return x;
+}
+
+// Filled-span bitmap: a maximal run of matching pixels is filled whole or not at all,
+// so testing one of its pixels tells whether it was already taken.
+static uint64_t* g_visited = NULL;
+static size_t g_visited_cap = 0;
+static CCE_Point* g_seeds = NULL;
+static size_t g_seed_count = 0, g_seed_cap = 0;
+static CCE_Span* g_sorted = NULL;
+static size_t g_sorted_cap = 0;
+static size_t* g_rows = NULL;
+static int g_rows_cap = 0;
+
+static int seed_push(int x, int y)
+{
+    if (g_seed_count == g_seed_cap) {
+        const size_t cap = g_seed_cap ? g_seed_cap * 2 : 1024;
+        CCE_Point* seeds = realloc(g_seeds, cap * sizeof(CCE_Point));
+        if (!seeds) {
+            ERRLOG;
+            return -1;
+        }
+        g_seeds = seeds;
+        g_seed_cap = cap;
+    }
+    g_seeds[g_seed_count++] = (CCE_Point){ x, y };
+    return 0;
+}
+
+// Pushes one seed per unfilled matching run of row y within [x0..x1].
+static int flood_seed_row(const CCE_Layer* layer, int x0, int x1, int y, const FloodKey* key, size_t words)
+{
+    if (y < 0 || y >= layer->scr_h) return 0;
+    const uint64_t* visited = g_visited + (size_t)y * words;
+    int x = x0;
+    while (x <= x1) {
+        x = flood_scan(layer, x, y, 1, x1 + 1, 0, key);
+        if (x > x1) break;
+        if (!(visited[x >> 6] >> (x & 63) & 1) && seed_push(x, y) < 0) return -1;
+        x = flood_scan(layer, x, y, 1, layer->scr_w, 1, key) + 1;
+    }
+    return 0;
+}
+
+int cce_layer_flood_fill(CCE_Layer* layer, int x, int y, CCE_Color color, int tolerance)
+{
+    if (!layer || layer->backend != CCE_LAYER_CPU || tolerance < 0) {
+        ERRLOG;
+        return -1;
+    }
+    if (x < 0 || y < 0 || x >= layer->scr_w || y >= layer->scr_h) return 0;
+
+    const CCE_Chunk* start = cce_layer_chunk(layer, cce_chunk_index(layer, x), cce_chunk_index(layer, y));
+    const FloodKey key = {
+        .seed = start->uniform ? cce_pack_color(start->fill)
+              : cce_pack_color(start->data[cce_chunk_local(layer, y) * start->w + cce_chunk_local(layer, x)]),
+        .tolerance = tolerance,
+    };
+    if (tolerance == 0 && key.seed == cce_pack_color(color) && layer->blend_mode == CCE_BLEND_REPLACE) return 0;
+
+    const size_t words = ((size_t)layer->scr_w + 63) / 64;
+    const size_t bits = words * (size_t)layer->scr_h;
+    if (bits > g_visited_cap) {
+        uint64_t* visited = realloc(g_visited, bits * sizeof(uint64_t));
+        if (!visited) {
+            ERRLOG;
+            return -1;
+        }
+        g_visited = visited;
+        g_visited_cap = bits;
+    }
+    memset(g_visited, 0, bits * sizeof(uint64_t));
+
+    // Find every span first and write afterwards, so matching always sees the original pixels.
+    SpanList* list = span_begin(layer);
+    g_seed_count = 0;
+    int result = seed_push(x, y);
+    while (result == 0 && g_seed_count > 0) {
+        const CCE_Point p = g_seeds[--g_seed_count];
+        uint64_t* visited = g_visited + (size_t)p.y * words;
+        if (visited[p.x >> 6] >> (p.x & 63) & 1) continue;
+
+        const int x0 = flood_scan(layer, p.x, p.y, -1, -1, 1, &key) + 1;
+        const int x1 = flood_scan(layer, p.x, p.y, 1, layer->scr_w, 1, &key) - 1;
+        span_push(list, p.y, x0, x1);
+        for (int i = x0; i <= x1;) {
+            const int n = 64 - (i & 63) < x1 - i + 1 ? 64 - (i & 63) : x1 - i + 1;
+            visited[i >> 6] |= (n == 64 ? ~(uint64_t)0 : (((uint64_t)1 << n) - 1)) << (i & 63);
+            i += n;
+        }
+        if (flood_seed_row(layer, x0, x1, p.y - 1, &key, words) < 0 ||
+            flood_seed_row(layer, x0, x1, p.y + 1, &key, words) < 0) {
+            result = -1;
+        }
+    }
+    if (result < 0 || list->failed) return -1;
+
+    // Counting sort by row: cce_raster_fill_spans walks chunk rows in order.
+    if (list->count > g_sorted_cap) {
+        CCE_Span* sorted = realloc(g_sorted, list->count * sizeof(CCE_Span));
+        if (!sorted) {
+            ERRLOG;
+            return -1;
+        }
+        g_sorted = sorted;
+        g_sorted_cap = list->count;
+    }
+    if (layer->scr_h + 1 > g_rows_cap) {
+        size_t* rows = realloc(g_rows, (size_t)(layer->scr_h + 1) * sizeof(size_t));
+        if (!rows) {
+            ERRLOG;
+            return -1;
+        }
+        g_rows = rows;
+        g_rows_cap = layer->scr_h + 1;
+    }
+    memset(g_rows, 0, (size_t)(layer->scr_h + 1) * sizeof(size_t));
+    for (size_t i = 0; i < list->count; i++) g_rows[list->spans[i].y + 1]++;
+    for (int r = 0; r < layer->scr_h; r++) g_rows[r + 1] += g_rows[r];
+    for (size_t i = 0; i < list->count; i++) g_sorted[g_rows[list->spans[i].y]++] = list->spans[i];
+
+    cce_raster_fill_spans(layer, g_sorted, list->count, color);
+    return 0;
+}
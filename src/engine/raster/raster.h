@@ -0,0 +1,44 @@
+/*
+===========================================================================
+MIT License
+
+Copyright (c) 2026 Stepan Pukhovskiy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+===========================================================================
+*/
+
+#ifndef CCE_RASTER_GUARD_H
+#define CCE_RASTER_GUARD_H
+
+#include "../../cce.h"
+
+#include <stddef.h>
+
+// Horizontal run of pixels [x0..x1] on row y.
+typedef struct
+{
+    int y, x0, x1;
+} CCE_Span;
+
+// Writes `color` over spans that are clipped to the layer, sorted by y and do not overlap, using the
+// layer blend mode. Spans sharing a chunk row are applied chunk by chunk with one dirty mark per chunk.
+void cce_raster_fill_spans(CCE_Layer* layer, const CCE_Span* spans, size_t count, CCE_Color color);
+
+#endif
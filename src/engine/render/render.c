@@ -24,20 +24,26 @@ SOFTWARE.
 ===========================================================================
 */
 
+#define _DEFAULT_SOURCE 1 // mmap/madvise flags under -std=c23
 #define GL_GLEXT_PROTOTYPES 1
 #include "render.h"
 #include "../engine.h"
 #include "../shader/shader.h"
+#include "../kernel/kernel.h"
+#include "../thread/thread.h"
 
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <GL/gl.h>
 #include <GL/glext.h>
 #include <stdarg.h>
 #include <string.h>
 #include <stdint.h>
+#include <stddef.h>
+#include <time.h>
 
 _Static_assert(sizeof(CCE_Color) == 4, "CCE_Color must be 4 bytes (RGBA u8) for packed fast paths");
 
@@ -64,6 +70,14 @@ _Static_assert(sizeof(CCE_Color) == 4, "CCE_Color must be 4 bytes (RGBA u8) for
 #define GL_STREAM_DRAW 0x88E0
 #endif
 
+// ARB_buffer_storage (core in 4.4).
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
 static GLuint g_quad_vao = 0;
 static GLuint g_quad_vbo = 0;
 static GLuint g_quad_ebo = 0;
@@ -76,11 +90,66 @@ static float g_projection[16];
 static int g_proj_w = 0;
 static int g_proj_h = 0;
 static void update_dirty_chunks(CCE_Layer* layer);
+static CCE_Color get_color_va(int pos_x, int pos_y, int offset_x, int offset_y, CCE_Palette palette, va_list args);
+static CCE_Color palette_color(CCE_Palette palette, int noise, ...);
+static CCE_Color palette_color_va(CCE_Palette palette, pct noise, va_list args);
 
 static GLuint g_batch_vao = 0;
-static GLuint g_batch_vbo = 0;
 static int g_batch_ready = 0;
 
+// Streaming ring: CCE_STREAM_REGIONS regions of one buffer, each guarded by a fence.
+// With ARB_buffer_storage the buffer is persistently mapped and data is written straight
+// into it; otherwise data goes through a staging copy and the buffer is orphaned on wrap.
+#define CCE_STREAM_REGIONS 3
+#define CCE_STREAM_REGION_BYTES ((size_t)2 * 1024 * 1024)
+#define CCE_UPLOAD_REGION_BYTES ((size_t)8 * 1024 * 1024)
+
+typedef struct {
+    GLenum target;
+    size_t region_bytes;
+    const char* name;
+    GLuint buffer;
+    unsigned char* mapped;   // persistent-coherent mapping (NULL => orphaning path)
+    unsigned char* staging;  // CPU staging for the orphaning path
+    int region;              // active region
+    size_t offset;           // write cursor inside active region
+    GLsync fences[CCE_STREAM_REGIONS];
+    size_t frame_bytes;
+    size_t last_frame_bytes;
+    int ready;
+} CCE_StreamRing;
+
+// Vertex/instance data for batched quads and instanced sprites.
+static CCE_StreamRing g_stream = { .target = GL_ARRAY_BUFFER, .region_bytes = CCE_STREAM_REGION_BYTES, .name = "vertex" };
+// Pixel upload arena shared by all CPU layers: dirty chunks of a frame are packed here.
+static CCE_StreamRing g_upload = { .target = GL_PIXEL_UNPACK_BUFFER, .region_bytes = CCE_UPLOAD_REGION_BYTES, .name = "upload" };
+
+// Quad batch. Textured triangles are appended to the open stream reservation and submitted
+// with a single draw call when texture/tint/target changes (or on explicit flush / layer end).
+typedef struct {
+    float* verts;      // (x,y,u,v) per vertex, points into the stream ring
+    int vertex_count;
+    int vertex_cap;    // vertices available in the current reservation
+    GLuint texture;
+    CCE_Color tint;
+    int depth;         // cce_batch_begin nesting
+} CCE_QuadBatch;
+
+static CCE_QuadBatch g_batch;
+static int g_clear_texture = -1; // ARB_clear_texture, probed on first upload
+static CCE_TextureRect* g_upload_rects = NULL; // upload_chunks scratch
+static uint64_t* g_upload_hashes = NULL;        // content hash per queued chunk, stored once uploaded
+static int g_upload_rects_cap = 0;
+
+// Instanced sprite pipeline: static unit quad + one CCE_SpriteInstance per sprite.
+static CCE_Shader g_inst_shader;
+static GLint g_inst_u_projection = -1;
+static GLint g_inst_u_texture = -1;
+static GLint g_inst_u_target_h = -1;
+static GLuint g_inst_vao = 0;
+static GLuint g_inst_quad_vbo = 0;
+static int g_inst_ready = 0;
+
 static GLuint g_white_tex = 0;
 
 static float srgb_to_linear_u8(pct c)
@@ -103,6 +172,8 @@ static int g_target_stack_top = 0;
 
 static CCE_Layer* g_active_layer = NULL; // used for auto begin/end
 
+static void batch_submit(void);
+
 static void ensure_white_texture(void)
 {
     if (g_white_tex != 0) return;
@@ -123,6 +194,8 @@ static int push_target(GLuint fbo, int w, int h)
         return -1;
     }
 
+    batch_submit();
+
     CCE_TargetSnapshot* s = &g_target_stack[g_target_stack_top++];
     glGetIntegerv(GL_VIEWPORT, s->viewport);
     GLint bound = 0;
@@ -140,6 +213,7 @@ static int push_target(GLuint fbo, int w, int h)
 static void pop_target(void)
 {
     if (g_target_stack_top <= 0) return;
+    batch_submit();
     CCE_TargetSnapshot* s = &g_target_stack[--g_target_stack_top];
 
     glBindFramebuffer(GL_FRAMEBUFFER, s->prev_fbo);
@@ -188,6 +262,7 @@ static int maybe_apply_layer_shader(CCE_Layer* layer, int each_frame)
     if (!layer || !layer->shader || !layer->shader->loaded) return 0;
 
     if (ensure_layer_shader_target(layer) != 0) return -1;
+    batch_submit();
 
     if (!each_frame && layer->shader_mode == CCE_LAYER_SHADER_BAKE_ON_DIRTY && !layer->shader_dirty) {
         return 0;
@@ -291,17 +366,147 @@ static int ensure_quad_pipeline(void)
     return 0;
 }
 
+// True if the context is at least GL core_major.core_minor or exposes `extension`.
+static int gl_has_feature(int core_major, int core_minor, const char* extension)
+{
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major > core_major || (major == core_major && minor >= core_minor)) return 1;
+
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if (ext && strcmp(ext, extension) == 0) return 1;
+    }
+    return 0;
+}
+
+static int stream_create(CCE_StreamRing* ring)
+{
+    if (ring->ready) return 0;
+    const size_t total = ring->region_bytes * CCE_STREAM_REGIONS;
+
+    glGenBuffers(1, &ring->buffer);
+    glBindBuffer(ring->target, ring->buffer);
+    if (gl_has_feature(4, 4, "GL_ARB_buffer_storage")) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(ring->target, (GLsizeiptr)total, NULL, flags);
+        ring->mapped = glMapBufferRange(ring->target, 0, (GLsizeiptr)total, flags);
+        if (!ring->mapped) {
+            // Storage is immutable; start over with a plain buffer.
+            glDeleteBuffers(1, &ring->buffer);
+            glGenBuffers(1, &ring->buffer);
+            glBindBuffer(ring->target, ring->buffer);
+        }
+    }
+    if (!ring->mapped) {
+        glBufferData(ring->target, (GLsizeiptr)total, NULL, GL_STREAM_DRAW);
+        ring->staging = malloc(ring->region_bytes);
+        if (!ring->staging) {
+            glBindBuffer(ring->target, 0);
+            glDeleteBuffers(1, &ring->buffer);
+            ring->buffer = 0;
+            return -1;
+        }
+    }
+    glBindBuffer(ring->target, 0);
+
+    ring->region = 0;
+    ring->offset = 0;
+    ring->ready = 1;
+    cce_printf("Stream ring (%s): %d x %zu KB, %s\n", ring->name, CCE_STREAM_REGIONS, ring->region_bytes / 1024,
+        ring->mapped ? "persistent-coherent" : "orphaning");
+    return 0;
+}
+
+static void stream_next_region(CCE_StreamRing* ring)
+{
+    if (ring->mapped) {
+        ring->fences[ring->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    ring->region = (ring->region + 1) % CCE_STREAM_REGIONS;
+    ring->offset = 0;
+
+    if (ring->mapped) {
+        // Region was last used CCE_STREAM_REGIONS rotations ago; normally already signaled.
+        GLsync fence = ring->fences[ring->region];
+        if (fence) {
+            GLenum res;
+            do {
+                res = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            } while (res == GL_TIMEOUT_EXPIRED);
+            glDeleteSync(fence);
+            ring->fences[ring->region] = 0;
+        }
+    } else if (ring->region == 0) {
+        // Orphan: the driver hands us fresh storage while old commands keep the previous one.
+        glBindBuffer(ring->target, ring->buffer);
+        glBufferData(ring->target, (GLsizeiptr)(ring->region_bytes * CCE_STREAM_REGIONS), NULL, GL_STREAM_DRAW);
+        glBindBuffer(ring->target, 0);
+    }
+}
+
+// Opens a reservation of at least `min_bytes` (16-byte aligned) in the active region and
+// returns the write pointer; `*out_avail` receives the usable size. Close with stream_end().
+static unsigned char* stream_begin(CCE_StreamRing* ring, size_t min_bytes, size_t* out_avail)
+{
+    if (!ring->ready || min_bytes == 0 || min_bytes > ring->region_bytes) return NULL;
+
+    size_t at = (ring->offset + 15) & ~(size_t)15;
+    if (at + min_bytes > ring->region_bytes) {
+        stream_next_region(ring);
+        at = 0;
+    }
+    ring->offset = at;
+    *out_avail = ring->region_bytes - at;
+
+    if (ring->mapped) {
+        return ring->mapped + (size_t)ring->region * ring->region_bytes + at;
+    }
+    return ring->staging;
+}
+
+// Commits `used` bytes of the open reservation; returns their byte offset inside the ring buffer.
+static size_t stream_end(CCE_StreamRing* ring, size_t used)
+{
+    const size_t at = (size_t)ring->region * ring->region_bytes + ring->offset;
+    if (!ring->mapped && used > 0) {
+        glBindBuffer(ring->target, ring->buffer);
+        glBufferSubData(ring->target, (GLintptr)at, (GLsizeiptr)used, ring->staging);
+        glBindBuffer(ring->target, 0);
+    }
+    ring->offset += used;
+    ring->frame_bytes += used;
+    return at;
+}
+
+// Closes the frame: records its byte count and moves to a fresh region so the GPU can
+// consume this one while the next frame is written.
+static void stream_end_frame(CCE_StreamRing* ring)
+{
+    ring->last_frame_bytes = ring->frame_bytes;
+    ring->frame_bytes = 0;
+    if (ring->last_frame_bytes > 0 && CCE_DEBUG == 1) {
+        cce_printf("Streamed %zu %s bytes this frame\n", ring->last_frame_bytes, ring->name);
+    }
+    if (ring->ready && ring->offset > 0) {
+        stream_next_region(ring);
+    }
+}
+
 static int ensure_batch_pipeline(void)
 {
     if (g_batch_ready) return 0;
     if (ensure_quad_pipeline() != 0) return -1;
+    if (stream_create(&g_stream) != 0) return -1;
 
     glGenVertexArrays(1, &g_batch_vao);
-    glGenBuffers(1, &g_batch_vbo);
 
     glBindVertexArray(g_batch_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, g_batch_vbo);
-    glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, g_stream.buffer);
 
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 4, (void*)0);
     glEnableVertexAttribArray(0);
@@ -313,10 +518,185 @@ static int ensure_batch_pipeline(void)
     return 0;
 }
 
+static int ensure_instanced_pipeline(void)
+{
+    if (g_inst_ready) return 0;
+    if (ensure_batch_pipeline() != 0) return -1;
+
+    // Instances use the bottom-left (x,y) convention of cce_draw_texture_region;
+    // the corner is flipped to top-left space in the shader.
+    const char* vs =
+        "#version 330 core\n"
+        "layout(location = 0) in vec2 aCorner;\n"
+        "layout(location = 1) in vec4 iRect;\n"
+        "layout(location = 2) in vec4 iUV;\n"
+        "layout(location = 3) in vec4 iColor;\n"
+        "uniform mat4 uProjection;\n"
+        "uniform float uTargetH;\n"
+        "out vec2 vUV;\n"
+        "out vec4 vColor;\n"
+        "void main() {\n"
+        "    float top = uTargetH - iRect.y - iRect.w;\n"
+        "    vec2 pos = vec2(iRect.x, top) + aCorner * iRect.zw;\n"
+        "    vUV = mix(iUV.xy, iUV.zw, aCorner);\n"
+        "    vColor = iColor;\n"
+        "    gl_Position = uProjection * vec4(pos, 0.0, 1.0);\n"
+        "}\n";
+
+    const char* fs =
+        "#version 330 core\n"
+        "in vec2 vUV;\n"
+        "in vec4 vColor;\n"
+        "uniform sampler2D uTexture;\n"
+        "out vec4 FragColor;\n"
+        "void main() {\n"
+        "    FragColor = texture(uTexture, vUV) * vColor;\n"
+        "}\n";
+
+    if (cce_shader_create_from_source(&g_inst_shader, vs, fs, "cce-sprite-instanced") != 0) {
+        return -1;
+    }
+
+    g_inst_u_projection = glGetUniformLocation(g_inst_shader.program, "uProjection");
+    g_inst_u_texture = glGetUniformLocation(g_inst_shader.program, "uTexture");
+    g_inst_u_target_h = glGetUniformLocation(g_inst_shader.program, "uTargetH");
+
+    glGenVertexArrays(1, &g_inst_vao);
+    glGenBuffers(1, &g_inst_quad_vbo);
+
+    glBindVertexArray(g_inst_vao);
+
+    // Triangle strip, corner (0,0) is the top-left of the sprite.
+    const float corners[8] = {0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+    glBindBuffer(GL_ARRAY_BUFFER, g_inst_quad_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 2, (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // Instance attributes live in the stream ring; pointers are set per draw (see set_instance_attribs).
+    for (GLuint a = 1; a <= 3; a++) {
+        glEnableVertexAttribArray(a);
+        glVertexAttribDivisor(a, 1);
+    }
+
+    glBindVertexArray(0);
+    g_inst_ready = 1;
+    return 0;
+}
+
+static void set_instance_attribs(size_t base)
+{
+    const GLsizei stride = (GLsizei)sizeof(CCE_SpriteInstance);
+    glBindBuffer(GL_ARRAY_BUFFER, g_stream.buffer);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(CCE_SpriteInstance, x)));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(CCE_SpriteInstance, u0)));
+    glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)(base + offsetof(CCE_SpriteInstance, tint)));
+}
+
+static int batch_deferred(void)
+{
+    // Inside layer recording or an explicit batch scope, quads wait for a state change / flush.
+    return g_batch.depth > 0 || g_active_layer != NULL;
+}
+
+// Returns a write pointer for `vertex_count` (x,y,u,v) vertices in the current batch.
+// Submits the pending batch first if texture or tint differ or the reservation is full.
+static float* batch_push(GLuint texture, CCE_Color tint, int vertex_count)
+{
+    if (g_batch.vertex_count > 0 &&
+        (g_batch.texture != texture || memcmp(&g_batch.tint, &tint, sizeof(tint)) != 0)) {
+        batch_submit();
+    }
+    if (g_batch.vertex_count + vertex_count > g_batch.vertex_cap) {
+        batch_submit();
+        size_t avail = 0;
+        unsigned char* p = stream_begin(&g_stream, (size_t)vertex_count * sizeof(float) * 4, &avail);
+        if (!p) return NULL;
+        g_batch.verts = (float*)(void*)p;
+        g_batch.vertex_cap = (int)(avail / (sizeof(float) * 4));
+    }
+
+    g_batch.texture = texture;
+    g_batch.tint = tint;
+    float* out = g_batch.verts + (size_t)g_batch.vertex_count * 4;
+    g_batch.vertex_count += vertex_count;
+    return out;
+}
+
+static void batch_submit(void)
+{
+    if (g_batch.vertex_count <= 0) return;
+    const int vertex_count = g_batch.vertex_count;
+    const size_t at = stream_end(&g_stream, (size_t)vertex_count * sizeof(float) * 4);
+    g_batch.vertex_count = 0;
+    g_batch.vertex_cap = 0;
+    g_batch.verts = NULL;
+
+    // UV convention for public GPU API: v=0 at TOP (matches stbtt atlas and stb_image default row order).
+    // We keep it as-is for the GL upload path we use (no vertical flip on load).
+
+    glUseProgram(g_quad_shader.program);
+    glUniformMatrix4fv(g_u_projection, 1, GL_FALSE, g_projection);
+    glUniform1i(g_u_texture, 0);
+    glUniform4f(
+        g_u_tint,
+        (float)g_batch.tint.r / 255.0f,
+        (float)g_batch.tint.g / 255.0f,
+        (float)g_batch.tint.b / 255.0f,
+        (float)g_batch.tint.a / 255.0f
+    );
+
+    glEnable(GL_BLEND);
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, g_batch.texture);
+
+    glBindVertexArray(g_batch_vao);
+    glDrawArrays(GL_TRIANGLES, (GLint)(at / (sizeof(float) * 4)), vertex_count);
+
+    glBindVertexArray(0);
+    glDisable(GL_BLEND);
+    glUseProgram(0);
+}
+
+int cce_batch_begin(void)
+{
+    g_batch.depth++;
+    return 0;
+}
+
+int cce_batch_flush(void)
+{
+    batch_submit();
+    return 0;
+}
+
+int cce_batch_end(void)
+{
+    if (g_batch.depth <= 0) return -1;
+    g_batch.depth--;
+    batch_submit();
+    return 0;
+}
+
+size_t cce_batch_get_streamed_bytes(void)
+{
+    return g_stream.last_frame_bytes;
+}
+
+void cce_render_end_frame(void)
+{
+    batch_submit();
+    stream_end_frame(&g_stream);
+    stream_end_frame(&g_upload);
+}
+
 void cce_render_prepare_layer(CCE_Layer* layer)
 {
     if (!layer) return;
     if (ensure_quad_pipeline() != 0) return;
+    batch_submit();
     if (layer->backend == CCE_LAYER_CPU) {
         update_dirty_chunks(layer);
     }
@@ -324,6 +704,7 @@ void cce_render_prepare_layer(CCE_Layer* layer)
 
 void cce_setup_2d_projection(int width, int height)
 {
+    batch_submit();
     g_proj_w = width;
     g_proj_h = height;
     // Top-left origin: left=0, right=width, top=0, bottom=height
@@ -332,6 +713,11 @@ void cce_setup_2d_projection(int width, int height)
     ensure_quad_pipeline();
 }
 
+int cce_render_projection_height(void)
+{
+    return g_proj_h;
+}
+
 int cce_draw_texture_region(
     const CCE_Texture* tex,
     float x, float y,
@@ -341,45 +727,27 @@ int cce_draw_texture_region(
     CCE_Color tint)
 {
     if (!tex || tex->id == 0 || w <= 0.0f || h <= 0.0f) return -1;
-    if (ensure_quad_pipeline() != 0) return -1;
+    if (ensure_batch_pipeline() != 0) return -1;
 
     // Match engine sprite convention: (x,y) are in bottom-left screen coordinates.
     // Convert to top-left screen coordinates used by our projection.
     const float y_top = (float)g_proj_h - y - h;
 
-    float verts[16] = {
-        // UV convention: v=0 at TOP (matches stbtt atlas and stb_image default row order).
-        x,     y_top,     u0, v0,
-        x + w, y_top,     u1, v0,
-        x + w, y_top + h, u1, v1,
-        x,     y_top + h, u0, v1
-    };
-
-    glUseProgram(g_quad_shader.program);
-    glUniformMatrix4fv(g_u_projection, 1, GL_FALSE, g_projection);
-    glUniform1i(g_u_texture, 0);
-    glUniform4f(
-        g_u_tint,
-        (float)tint.r / 255.0f,
-        (float)tint.g / 255.0f,
-        (float)tint.b / 255.0f,
-        (float)tint.a / 255.0f
-    );
-
-    glEnable(GL_BLEND);
-    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    float* v = batch_push((GLuint)tex->id, tint, 6);
+    if (!v) return -1;
 
-    glBindVertexArray(g_quad_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, g_quad_vbo);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
+    // UV convention: v=0 at TOP (matches stbtt atlas and stb_image default row order).
+    const float x0 = x, x1 = x + w;
+    const float y0 = y_top, y1 = y_top + h;
+    *v++ = x0; *v++ = y0; *v++ = u0; *v++ = v0;
+    *v++ = x1; *v++ = y0; *v++ = u1; *v++ = v0;
+    *v++ = x1; *v++ = y1; *v++ = u1; *v++ = v1;
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, (GLuint)tex->id);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    *v++ = x1; *v++ = y1; *v++ = u1; *v++ = v1;
+    *v++ = x0; *v++ = y1; *v++ = u0; *v++ = v1;
+    *v++ = x0; *v++ = y0; *v++ = u0; *v++ = v0;
 
-    glBindVertexArray(0);
-    glDisable(GL_BLEND);
-    glUseProgram(0);
+    if (!batch_deferred()) batch_submit();
     return 0;
 }
 
@@ -393,30 +761,55 @@ int cce_draw_triangles_textured(
     if ((vertex_count % 3) != 0) return -1; // triangles
     if (ensure_batch_pipeline() != 0) return -1;
 
-    // UV convention for public GPU API: v=0 at TOP (matches stbtt atlas and stb_image default row order).
-    // We keep it as-is for the GL upload path we use (no vertical flip on load).
+    // Long glyph runs may exceed one stream region; split on triangle boundaries.
+    const int max_run = (int)(CCE_STREAM_REGION_BYTES / (sizeof(float) * 4 * 3)) * 3;
+    while (vertex_count > 0) {
+        const int run = vertex_count < max_run ? vertex_count : max_run;
+        float* v = batch_push((GLuint)texture_id, tint, run);
+        if (!v) return -1;
+        memcpy(v, verts_xyuv, (size_t)run * sizeof(float) * 4);
+        verts_xyuv += (size_t)run * 4;
+        vertex_count -= run;
+    }
 
-    glUseProgram(g_quad_shader.program);
-    glUniformMatrix4fv(g_u_projection, 1, GL_FALSE, g_projection);
-    glUniform1i(g_u_texture, 0);
-    glUniform4f(
-        g_u_tint,
-        (float)tint.r / 255.0f,
-        (float)tint.g / 255.0f,
-        (float)tint.b / 255.0f,
-        (float)tint.a / 255.0f
-    );
+    if (!batch_deferred()) batch_submit();
+    return 0;
+}
+
+int cce_draw_sprites_instanced(const CCE_Texture* texture, const CCE_SpriteInstance* instances, int count)
+{
+    if (!texture || texture->id == 0 || !instances || count < 0) return -1;
+    if (count == 0) return 0;
+    if (ensure_instanced_pipeline() != 0) return -1;
+
+    // Keep draw order with quads recorded before this call.
+    batch_submit();
+
+    glUseProgram(g_inst_shader.program);
+    glUniformMatrix4fv(g_inst_u_projection, 1, GL_FALSE, g_projection);
+    glUniform1i(g_inst_u_texture, 0);
+    glUniform1f(g_inst_u_target_h, (float)g_proj_h);
 
     glEnable(GL_BLEND);
     glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, (GLuint)texture_id);
-
-    glBindVertexArray(g_batch_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, g_batch_vbo);
-    glBufferData(GL_ARRAY_BUFFER, (size_t)vertex_count * sizeof(float) * 4, verts_xyuv, GL_STREAM_DRAW);
-    glDrawArrays(GL_TRIANGLES, 0, vertex_count);
+    glBindTexture(GL_TEXTURE_2D, (GLuint)texture->id);
+
+    glBindVertexArray(g_inst_vao);
+    const int max_run = (int)(CCE_STREAM_REGION_BYTES / sizeof(CCE_SpriteInstance));
+    while (count > 0) {
+        const int run = count < max_run ? count : max_run;
+        const size_t bytes = (size_t)run * sizeof(CCE_SpriteInstance);
+        size_t avail = 0;
+        unsigned char* dst = stream_begin(&g_stream, bytes, &avail);
+        if (!dst) break;
+        memcpy(dst, instances, bytes);
+        set_instance_attribs(stream_end(&g_stream, bytes));
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, run);
+        instances += run;
+        count -= run;
+    }
 
     glBindVertexArray(0);
     glDisable(GL_BLEND);
@@ -427,12 +820,71 @@ int cce_draw_triangles_textured(
 
 float procedural_noise(int x, int y, int seed)
 {
-    uint32_t n = (x * 1836311903) ^ (y * 2971215073) ^ (seed * 1073741827);
-    n = (n >> 13) ^ n;
-    n = (n * (n * n * 60493 + 19990303) + 1376312589);
+    const uint32_t n = cce_noise_hash((uint32_t)x, (uint32_t)y, (uint32_t)seed);
     return (float)(n & 0x7FFFFFFF) / 2147483647.0f;
 }
 
+static size_t chunk_page_size(void)
+{
+    const long page = sysconf(_SC_PAGESIZE);
+    return page > 0 ? (size_t)page : 4096;
+}
+
+static CCE_Color* chunk_slot(const CCE_Layer* layer, const CCE_Chunk* chunk)
+{
+    return layer->pixels + ((size_t)chunk->y * (size_t)layer->chunk_count_x + (size_t)chunk->x) * layer->chunk_stride;
+}
+
+void cce_chunk_buffer_release(CCE_ChunkBuffer* buffer)
+{
+    if (--buffer->refs > 0) return;
+    free(buffer->pixels);
+    free(buffer);
+}
+
+void cce_chunk_unshare(CCE_Chunk* chunk)
+{
+    CCE_ChunkBuffer* buffer = chunk->shared;
+    chunk->shared = NULL;
+    if (buffer->refs == 1) {
+        // No snapshot left to read the slot.
+        cce_chunk_buffer_release(buffer);
+        return;
+    }
+    const size_t bytes = (size_t)buffer->w * (size_t)buffer->h * sizeof(CCE_Color);
+    buffer->pixels = malloc(bytes);
+    if (buffer->pixels) {
+        memcpy(buffer->pixels, buffer->slot, bytes);
+    } else {
+        ERRLOG;
+    }
+    buffer->slot = NULL;
+    cce_chunk_buffer_release(buffer);
+}
+
+void cce_chunk_back(CCE_Layer* layer, CCE_Chunk* chunk, int preserve)
+{
+    if (chunk->shared) cce_chunk_unshare(chunk);
+    if (!chunk->uniform) return;
+    const uint32_t packed = cce_pack_color(chunk->fill);
+    const int fresh = chunk->data == NULL;
+    chunk->data = chunk_slot(layer, chunk);
+    chunk->uniform = false;
+    // Released slots read back as zero, so a transparent fill needs no writes at all.
+    if (preserve && !(fresh && packed == 0)) {
+        cce_kernels.fill((uint32_t*)(void*)chunk->data, packed, (size_t)chunk->w * (size_t)chunk->h);
+    }
+}
+
+// Returns the pages of a uniform chunk to the OS; they read back as zero if touched again.
+static void chunk_release(CCE_Layer* layer, CCE_Chunk* chunk)
+{
+    if (!chunk->uniform || !chunk->data) return;
+    if (chunk->shared) cce_chunk_unshare(chunk);
+    madvise(chunk->data, layer->chunk_stride * sizeof(CCE_Color), MADV_DONTNEED);
+    chunk->data = NULL;
+}
+
 CCE_Layer* cce_layer_create(int screen_w, int screen_h, char * name, CCE_LayerBackend backend)
 {
     if (backend == CCE_LAYER_GPU) {
@@ -444,6 +896,17 @@ CCE_Layer* cce_layer_create(int screen_w, int screen_h, char * name, CCE_LayerBa
 
 CCE_Layer* cce_layer_cpu_create(int screen_w, int screen_h, char * name)
 {
+    return cce_layer_cpu_create_ex(screen_w, screen_h, name, 0);
+}
+
+CCE_Layer* cce_layer_cpu_create_ex(int screen_w, int screen_h, char * name, int chunk_size)
+{
+    if (chunk_size <= 0) chunk_size = engine_chunk_size;
+    if (chunk_size < CCE_CHUNK_SIZE_MIN || chunk_size > CCE_CHUNK_SIZE_MAX) {
+        ERRLOG;
+        return NULL;
+    }
+
     CCE_Layer* layer = malloc(sizeof(CCE_Layer));
     if (!layer) return NULL;
     memset(layer, 0, sizeof(*layer));
@@ -451,17 +914,21 @@ CCE_Layer* cce_layer_cpu_create(int screen_w, int screen_h, char * name)
     layer->backend = CCE_LAYER_CPU;
     layer->scr_w = screen_w;
     layer->scr_h = screen_h;
-    layer->chunk_size = CHUNK_SIZE;
+    layer->chunk_size = chunk_size;
+    // Степень двойки: индексы чанков считаются сдвигом и маской
+    layer->chunk_shift = 0;
+    if ((chunk_size & (chunk_size - 1)) == 0) {
+        while ((1 << layer->chunk_shift) < chunk_size) layer->chunk_shift++;
+    }
     layer->enabled = true;
-    layer->has_dirty = true; // newly created layer uploads initial texture data
     layer->shader = NULL;
     layer->shader_mode = CCE_LAYER_SHADER_NONE;
     layer->shader_coefficient = 1.0f;
     layer->shader_dirty = 0;
 
     // Округление вверх для количества чанков
-    layer->chunk_count_x = (screen_w + CHUNK_SIZE - 1) / CHUNK_SIZE;
-    layer->chunk_count_y = (screen_h + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    layer->chunk_count_x = (screen_w + chunk_size - 1) / chunk_size;
+    layer->chunk_count_y = (screen_h + chunk_size - 1) / chunk_size;
 
     if (name) {
         layer->name = malloc(strlen(name) + 1);
@@ -471,25 +938,42 @@ CCE_Layer* cce_layer_cpu_create(int screen_w, int screen_h, char * name)
         layer->name[0] = '\0';
     }
 
-    // Выделяем память под массив указателей на строки чанков
-    layer->chunks = malloc(layer->chunk_count_y * sizeof(CCE_Chunk**));
+    // Одна арена: заголовки чанков (плоский массив), затем пиксели всех чанков.
+    // Every chunk owns a fixed page-aligned slot, so chunk (x,y) is addressed in O(1). The arena is
+    // only reserved: a slot's pages become resident on the chunk's first non-uniform write and are
+    // handed back once it turns uniform again.
+    const size_t page = chunk_page_size();
+    const size_t chunk_count = (size_t)layer->chunk_count_x * (size_t)layer->chunk_count_y;
+    const size_t header_bytes = CCE_ALIGN_UP(chunk_count * sizeof(CCE_Chunk), page);
+    const size_t slot_bytes = CCE_ALIGN_UP((size_t)chunk_size * chunk_size * sizeof(CCE_Color), page);
+    const size_t arena_bytes = header_bytes + chunk_count * slot_bytes;
+
+    unsigned char* arena = mmap(NULL, arena_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (arena == MAP_FAILED) {
+        free(layer->name);
+        free(layer);
+        return NULL;
+    }
+    layer->chunks = (CCE_Chunk*)(void*)arena;
+    layer->pixels = (CCE_Color*)(void*)(arena + header_bytes);
+    layer->chunk_stride = slot_bytes / sizeof(CCE_Color);
+    layer->arena_bytes = arena_bytes;
 
-    cce_printf("New CPU Layer: screen %dx%d, chunks %dx%d, name \"%s\"\n",
-        screen_w, screen_h, layer->chunk_count_x, layer->chunk_count_y, layer->name);
+    cce_printf("New CPU Layer: screen %dx%d, chunks %dx%d of %dpx, name \"%s\"\n",
+        screen_w, screen_h, layer->chunk_count_x, layer->chunk_count_y, chunk_size, layer->name);
 
     for (int y = 0; y < layer->chunk_count_y; y++) {
-        layer->chunks[y] = malloc(layer->chunk_count_x * sizeof(CCE_Chunk*));
         for (int x = 0; x < layer->chunk_count_x; x++) {
-            CCE_Chunk* chunk = (CCE_Chunk*)malloc(sizeof(CCE_Chunk));
+            CCE_Chunk* chunk = cce_layer_chunk(layer, x, y);
             chunk->x = x;
             chunk->y = y;
-            chunk->w = (x == layer->chunk_count_x - 1) ? screen_w - x * CHUNK_SIZE : CHUNK_SIZE;
-            chunk->h = (y == layer->chunk_count_y - 1) ? screen_h - y * CHUNK_SIZE : CHUNK_SIZE;
-            chunk->data = malloc(chunk->w * chunk->h * sizeof(CCE_Color));
-            memset(chunk->data, 0, chunk->w * chunk->h * sizeof(CCE_Color));
-            chunk->dirty = true;
+            chunk->w = (x == layer->chunk_count_x - 1) ? screen_w - x * chunk_size : chunk_size;
+            chunk->h = (y == layer->chunk_count_y - 1) ? screen_h - y * chunk_size : chunk_size;
+            // Starts transparent with no pixel memory; the first upload clears the texture.
+            chunk->data = NULL;
             chunk->visible = true;
-            layer->chunks[y][x] = chunk;
+            chunk->uniform = true;
+            cce_chunk_mark_dirty(layer, chunk, 0, 0, chunk->w - 1, chunk->h - 1);
         }
     }
 
@@ -502,16 +986,6 @@ CCE_Layer* cce_layer_cpu_create(int screen_w, int screen_h, char * name)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-    // PBO for async uploads
-    layer->pbo_size = CHUNK_SIZE * CHUNK_SIZE * 4;
-    layer->current_pbo_index = 0;
-    glGenBuffers(2, layer->pbo_ids);
-    for (int i = 0; i < 2; i++) {
-        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, layer->pbo_ids[i]);
-        glBufferData(GL_PIXEL_UNPACK_BUFFER, layer->pbo_size, NULL, GL_STREAM_DRAW);
-    }
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
-
     return layer;
 }
 
@@ -596,6 +1070,7 @@ int cce_layer_end(CCE_Layer* layer)
     if (!layer) return -1;
     if (g_active_layer != layer) return 0;
 
+    batch_submit();
     if (layer->backend == CCE_LAYER_GPU) {
         pop_target();
     }
@@ -621,6 +1096,7 @@ int cce_layer_clear(CCE_Layer* layer, CCE_Color color)
             auto_wrapped = 1;
         }
 
+        batch_submit();
         glDisable(GL_BLEND);
         const float lr = srgb_to_linear_u8(color.r);
         const float lg = srgb_to_linear_u8(color.g);
@@ -635,22 +1111,12 @@ int cce_layer_clear(CCE_Layer* layer, CCE_Color color)
         return 0;
     }
 
-    // CPU layer: clear all chunks in-place (fast path).
-    const uint32_t packed =
-        ((uint32_t)color.r) |
-        ((uint32_t)color.g << 8) |
-        ((uint32_t)color.b << 16) |
-        ((uint32_t)color.a << 24);
+    // CPU layer: every chunk becomes uniform, no pixels are written.
     for (int y = 0; y < layer->chunk_count_y; y++) {
         for (int x = 0; x < layer->chunk_count_x; x++) {
-            CCE_Chunk* chunk = layer->chunks[y][x];
-            uint32_t* p = (uint32_t*)(void*)chunk->data;
-            size_t count = (size_t)chunk->w * (size_t)chunk->h;
-            for (size_t i = 0; i < count; i++) p[i] = packed;
-            chunk->dirty = true;
+            cce_chunk_set_uniform(layer, cce_layer_chunk(layer, x, y), color);
         }
     }
-    layer->has_dirty = true;
     return 0;
 }
 
@@ -680,6 +1146,68 @@ int cce_layer_set_shader_tint(CCE_Layer* layer, CCE_Color tint)
     return 0;
 }
 
+int cce_layer_set_upload_hashing(CCE_Layer* layer, bool enabled)
+{
+    if (!layer || layer->backend != CCE_LAYER_CPU) {
+        ERRLOG;
+        return -1;
+    }
+    layer->hash_uploads = enabled ? true : false;
+    return 0;
+}
+
+int cce_layer_get_upload_stats(const CCE_Layer* layer, CCE_UploadStats* out)
+{
+    if (!layer || !out) return -1;
+    *out = layer->upload_stats;
+    return 0;
+}
+
+int cce_layer_set_blend_mode(CCE_Layer* layer, CCE_BlendMode mode)
+{
+    if (!layer || layer->backend != CCE_LAYER_CPU || mode < CCE_BLEND_REPLACE || mode > CCE_BLEND_MULTIPLY) {
+        ERRLOG;
+        return -1;
+    }
+    layer->blend_mode = mode;
+    return 0;
+}
+
+static CCE_Color blend_color(CCE_BlendMode mode, CCE_Color dst, CCE_Color src)
+{
+    const uint32_t out = cce_blend_pixel(mode, cce_pack_color(src), cce_pack_color(dst));
+    memcpy(&dst, &out, sizeof(dst));
+    return dst;
+}
+
+// Blends a solid colour into chunk-local rect [x0..x1]x[y0..y1] with a non-REPLACE mode; the caller
+// marks the rect dirty when this returns 1. A uniform chunk covered whole stays uniform.
+static int chunk_blend_rect(CCE_Layer* layer, CCE_Chunk* chunk, CCE_BlendMode mode,
+                            int x0, int y0, int x1, int y1, uint32_t packed)
+{
+    // Zero alpha leaves every mode's destination as it was.
+    if ((packed >> 24) == 0) return 0;
+    if (chunk->uniform) {
+        const uint32_t fill = cce_pack_color(chunk->fill);
+        const uint32_t out = cce_blend_pixel(mode, packed, fill);
+        if (out == fill) return 0;
+        if (x0 == 0 && y0 == 0 && x1 == chunk->w - 1 && y1 == chunk->h - 1) {
+            memcpy(&chunk->fill, &out, sizeof(chunk->fill));
+            return 1;
+        }
+    }
+    cce_chunk_materialize(layer, chunk);
+
+    uint32_t src[CCE_CHUNK_SIZE_MAX];
+    const size_t span = (size_t)(x1 - x0 + 1);
+    cce_kernels.fill(src, packed, span);
+    uint32_t* row0 = (uint32_t*)(void*)chunk->data;
+    for (int ly = y0; ly <= y1; ly++) {
+        cce_blend_span(mode, row0 + (size_t)ly * (size_t)chunk->w + (size_t)x0, src, span);
+    }
+    return 1;
+}
+
 void cce_set_pixel(CCE_Layer* layer, int screen_x, int screen_y, CCE_Color color)
 {
     if (!layer) return;
@@ -695,18 +1223,18 @@ void cce_set_pixel(CCE_Layer* layer, int screen_x, int screen_y, CCE_Color color
     }
     
     // Определяем, какой чанк
-    int chunk_x = screen_x / layer->chunk_size;
-    int chunk_y = screen_y / layer->chunk_size;
+    int chunk_x = cce_chunk_index(layer, screen_x);
+    int chunk_y = cce_chunk_index(layer, screen_y);
     
     // Проверяем границы чанков
     if (chunk_x >= 0 && chunk_x < layer->chunk_count_x && 
         chunk_y >= 0 && chunk_y < layer->chunk_count_y) {
         
-        CCE_Chunk* chunk = layer->chunks[chunk_y][chunk_x];
+        CCE_Chunk* chunk = cce_layer_chunk(layer, chunk_x, chunk_y);
         
         // Локальные координаты внутри чанка
-        int local_x = screen_x % layer->chunk_size;
-        int local_y = screen_y % layer->chunk_size;
+        int local_x = cce_chunk_local(layer, screen_x);
+        int local_y = cce_chunk_local(layer, screen_y);
         
         // Проверяем границы внутри чанка (для последнего чанка в строке/столбце)
         if (local_x >= 0 && local_x < chunk->w && 
@@ -716,18 +1244,18 @@ void cce_set_pixel(CCE_Layer* layer, int screen_x, int screen_y, CCE_Color color
             int index = local_y * chunk->w + local_x;
             
             // Проверяем, действительно ли изменился пиксель
-            CCE_Color old_color = chunk->data[index];
+            CCE_Color old_color = chunk->uniform ? chunk->fill : chunk->data[index];
+            if (layer->blend_mode != CCE_BLEND_REPLACE) color = blend_color(layer->blend_mode, old_color, color);
             if (old_color.r == color.r && old_color.g == color.g && 
                 old_color.b == color.b && old_color.a == color.a) {
                 return;  // Пиксель не изменился, пропускаем
             }
             
+            cce_chunk_materialize(layer, chunk);
             chunk->data[index] = color;
             
-            // Помечаем весь чанк как грязный
-            chunk->dirty = true;
-            layer->has_dirty = true;
-            layer->shader_dirty = 1;
+            // Помечаем изменённую область чанка как грязную
+            cce_chunk_mark_dirty(layer, chunk, local_x, local_y, local_x, local_y);
         }
     }
 }
@@ -793,17 +1321,14 @@ void cce_set_pixel_rect(CCE_Layer* layer, int x0, int y0, int x1, int y1, CCE_Co
 
     // Fast path for solid fills: write packed 32-bit pixels and mark chunk dirty once.
     // This is especially useful for clears/rect fills (e.g. UI animated regions).
-    const uint32_t packed =
-        ((uint32_t)color.r) |
-        ((uint32_t)color.g << 8) |
-        ((uint32_t)color.b << 16) |
-        ((uint32_t)color.a << 24);
+    const uint32_t packed = cce_pack_color(color);
+    const CCE_BlendMode mode = cce_solid_blend_mode(layer, packed);
     
     // Определяем затронутые чанки
-    int chunk_x0 = x0 / layer->chunk_size;
-    int chunk_y0 = y0 / layer->chunk_size;
-    int chunk_x1 = x1 / layer->chunk_size;
-    int chunk_y1 = y1 / layer->chunk_size;
+    int chunk_x0 = cce_chunk_index(layer, x0);
+    int chunk_y0 = cce_chunk_index(layer, y0);
+    int chunk_x1 = cce_chunk_index(layer, x1);
+    int chunk_y1 = cce_chunk_index(layer, y1);
     
     // Заполняем область батчем
     for (int cy = chunk_y0; cy <= chunk_y1; cy++) {
@@ -811,7 +1336,7 @@ void cce_set_pixel_rect(CCE_Layer* layer, int x0, int y0, int x1, int y1, CCE_Co
             if (cx < 0 || cx >= layer->chunk_count_x || 
                 cy < 0 || cy >= layer->chunk_count_y) continue;
             
-            CCE_Chunk* chunk = layer->chunks[cy][cx];
+            CCE_Chunk* chunk = cce_layer_chunk(layer, cx, cy);
             
             // Вычисляем область пересечения
             int chunk_screen_x = cx * layer->chunk_size;
@@ -824,121 +1349,923 @@ void cce_set_pixel_rect(CCE_Layer* layer, int x0, int y0, int x1, int y1, CCE_Co
             int local_y1 = (y1 < chunk_screen_y + chunk->h) ? 
                            (y1 - chunk_screen_y) : (chunk->h - 1);
             
+            if (mode != CCE_BLEND_REPLACE) {
+                if (chunk_blend_rect(layer, chunk, mode, local_x0, local_y0, local_x1, local_y1, packed)) {
+                    cce_chunk_mark_dirty(layer, chunk, local_x0, local_y0, local_x1, local_y1);
+                }
+                continue;
+            }
+
+            // Whole chunk covered: it becomes uniform, nothing is written.
+            if (local_x0 == 0 && local_y0 == 0 && local_x1 == chunk->w - 1 && local_y1 == chunk->h - 1) {
+                cce_chunk_set_uniform(layer, chunk, color);
+                continue;
+            }
+            if (chunk->uniform && cce_color_equal(chunk->fill, color)) continue;
+            cce_chunk_materialize(layer, chunk);
+
             // Fill rows with packed pixels.
             uint32_t* row0 = (uint32_t*)(void*)chunk->data;
-            const int span = local_x1 - local_x0 + 1;
+            const size_t span = (size_t)(local_x1 - local_x0 + 1);
             int any = 0;
             for (int ly = local_y0; ly <= local_y1; ly++) {
-                uint32_t* p = row0 + (size_t)ly * (size_t)chunk->w + (size_t)local_x0;
-                for (int i = 0; i < span; i++) {
-                    p[i] = packed;
-                }
+                cce_kernels.fill(row0 + (size_t)ly * (size_t)chunk->w + (size_t)local_x0, packed, span);
                 any = 1;
             }
             if (any) {
-                chunk->dirty = true;
-                layer->has_dirty = true;
-                layer->shader_dirty = 1;
+                cce_chunk_mark_dirty(layer, chunk, local_x0, local_y0, local_x1, local_y1);
             }
         }
     }
 }
 
 
-void update_dirty_chunks(CCE_Layer* layer)
+int cce_layer_lock_rect(CCE_Layer* layer, int x, int y, int w, int h, CCE_PixelSpan* out)
+{
+    if (!out) return -1;
+    memset(out, 0, sizeof(*out));
+    if (!layer || layer->backend != CCE_LAYER_CPU || w < 0 || h < 0) {
+        ERRLOG;
+        return -1;
+    }
+
+    // Far edges in 64-bit so x + w cannot overflow before the clip.
+    const int64_t ex = (int64_t)x + w, ey = (int64_t)y + h;
+    int x0 = x < 0 ? 0 : x;
+    int y0 = y < 0 ? 0 : y;
+    int x1 = ex > layer->scr_w ? layer->scr_w : (int)ex; // exclusive
+    int y1 = ey > layer->scr_h ? layer->scr_h : (int)ey;
+    if (x0 >= x1 || y0 >= y1) return 0;
+
+    const int chunk_x0 = cce_chunk_index(layer, x0);
+    const int chunk_y0 = cce_chunk_index(layer, y0);
+    const int chunk_x1 = cce_chunk_index(layer, x1 - 1);
+    const int chunk_y1 = cce_chunk_index(layer, y1 - 1);
+    const int count = (chunk_x1 - chunk_x0 + 1) * (chunk_y1 - chunk_y0 + 1);
+
+    CCE_PixelRegion* regions = malloc((size_t)count * sizeof(CCE_PixelRegion));
+    if (!regions) {
+        ERRLOG;
+        return -1;
+    }
+
+    int n = 0;
+    for (int cy = chunk_y0; cy <= chunk_y1; cy++) {
+        for (int cx = chunk_x0; cx <= chunk_x1; cx++) {
+            CCE_Chunk* chunk = cce_layer_chunk(layer, cx, cy);
+            const int sx = cx * layer->chunk_size;
+            const int sy = cy * layer->chunk_size;
+            const int rx0 = x0 > sx ? x0 : sx;
+            const int ry0 = y0 > sy ? y0 : sy;
+            const int rx1 = x1 < sx + chunk->w ? x1 : sx + chunk->w;
+            const int ry1 = y1 < sy + chunk->h ? y1 : sy + chunk->h;
+
+            cce_chunk_materialize(layer, chunk);
+            CCE_PixelRegion* r = &regions[n++];
+            r->x = rx0;
+            r->y = ry0;
+            r->w = rx1 - rx0;
+            r->h = ry1 - ry0;
+            r->stride = chunk->w;
+            r->pixels = chunk->data + (size_t)(ry0 - sy) * (size_t)chunk->w + (size_t)(rx0 - sx);
+        }
+    }
+
+    out->x = x0;
+    out->y = y0;
+    out->w = x1 - x0;
+    out->h = y1 - y0;
+    out->count = n;
+    out->regions = regions;
+    layer->lock_count++;
+    return 0;
+}
+
+void cce_layer_unlock(CCE_Layer* layer, CCE_PixelSpan* span)
+{
+    if (!span) return;
+    if (layer && layer->backend == CCE_LAYER_CPU && span->regions) {
+        layer->lock_count--;
+        for (int i = 0; i < span->count; i++) {
+            const CCE_PixelRegion* r = &span->regions[i];
+            const int cx = cce_chunk_index(layer, r->x);
+            const int cy = cce_chunk_index(layer, r->y);
+            const int lx = cce_chunk_local(layer, r->x);
+            const int ly = cce_chunk_local(layer, r->y);
+            cce_chunk_mark_dirty(layer, cce_layer_chunk(layer, cx, cy), lx, ly, lx + r->w - 1, ly + r->h - 1);
+        }
+    }
+    free(span->regions);
+    memset(span, 0, sizeof(*span));
+}
+
+/* Parallel chunk work */
+
+// Below this many pixels the pool wake-up costs more than it saves.
+#define CCE_PARALLEL_MIN_PIXELS (64 * 1024)
+
+typedef struct
+{
+    CCE_Chunk* chunk;
+    int x0, y0, x1, y1; // chunk-local rect (inclusive)
+    int changed;
+} CCE_ChunkJob;
+
+typedef struct
+{
+    CCE_Layer* layer;
+    CCE_ChunkJob* jobs;
+    CCE_ChunkFn fn;
+    void* userdata;
+    uint32_t packed;
+    int origin_x, origin_y; // palette cell grid origin
+    int cell_size;
+    int offset_x, offset_y;
+    uint32_t seed;
+    const uint32_t* lut; // packed palette colour per noise byte
+    const CCE_NoiseField* field; // drawn with values[0] at (origin_x, origin_y)
+    const struct CCE_ScatterWrite* scatter; // bucketed writes; job i owns [scatter_start[i], scatter_start[i + 1])
+    const size_t* scatter_start;
+} CCE_ChunkWork;
+
+// Builds one job per chunk intersecting the clipped screen rect [x0..x1]x[y0..y1].
+static CCE_ChunkJob* collect_chunk_jobs(CCE_Layer* layer, int x0, int y0, int x1, int y1, int* out_count)
+{
+    const int chunk_x0 = cce_chunk_index(layer, x0);
+    const int chunk_y0 = cce_chunk_index(layer, y0);
+    const int chunk_x1 = cce_chunk_index(layer, x1);
+    const int chunk_y1 = cce_chunk_index(layer, y1);
+    const int count = (chunk_x1 - chunk_x0 + 1) * (chunk_y1 - chunk_y0 + 1);
+
+    CCE_ChunkJob* jobs = malloc((size_t)count * sizeof(CCE_ChunkJob));
+    if (!jobs) {
+        ERRLOG;
+        *out_count = 0;
+        return NULL;
+    }
+
+    int n = 0;
+    for (int cy = chunk_y0; cy <= chunk_y1; cy++) {
+        for (int cx = chunk_x0; cx <= chunk_x1; cx++) {
+            CCE_Chunk* chunk = cce_layer_chunk(layer, cx, cy);
+            const int sx = cx * layer->chunk_size;
+            const int sy = cy * layer->chunk_size;
+            CCE_ChunkJob* job = &jobs[n++];
+            job->chunk = chunk;
+            job->x0 = (x0 > sx) ? x0 - sx : 0;
+            job->y0 = (y0 > sy) ? y0 - sy : 0;
+            job->x1 = (x1 < sx + chunk->w) ? x1 - sx : chunk->w - 1;
+            job->y1 = (y1 < sy + chunk->h) ? y1 - sy : chunk->h - 1;
+            job->changed = 0;
+        }
+    }
+    *out_count = n;
+    return jobs;
+}
+
+// Runs the jobs (in parallel when worth it), then queues changed chunks on the calling thread.
+static void run_chunk_jobs(CCE_Layer* layer, CCE_ChunkWork* work, int count, long pixels, void (*fn)(int, void*))
+{
+    if (pixels >= CCE_PARALLEL_MIN_PIXELS) {
+        cce_parallel_for(count, fn, work);
+    } else {
+        for (int i = 0; i < count; i++) fn(i, work);
+    }
+
+    for (int i = 0; i < count; i++) {
+        const CCE_ChunkJob* job = &work->jobs[i];
+        if (job->changed) {
+            cce_chunk_mark_dirty(layer, job->chunk, job->x0, job->y0, job->x1, job->y1);
+        }
+    }
+}
+
+static void user_chunk_job(int index, void* userdata)
+{
+    CCE_ChunkWork* work = userdata;
+    CCE_ChunkJob* job = &work->jobs[index];
+    cce_chunk_materialize(work->layer, job->chunk);
+    job->changed = work->fn(work->layer, job->chunk, work->userdata) != 0;
+}
+
+static void fill_chunk_job(int index, void* userdata)
+{
+    CCE_ChunkWork* work = userdata;
+    CCE_ChunkJob* job = &work->jobs[index];
+    CCE_Chunk* chunk = job->chunk;
+    const CCE_BlendMode mode = cce_solid_blend_mode(work->layer, work->packed);
+    if (mode != CCE_BLEND_REPLACE) {
+        job->changed = chunk_blend_rect(work->layer, chunk, mode, job->x0, job->y0, job->x1, job->y1, work->packed);
+        return;
+    }
+    const uint32_t fill = chunk->uniform ? cce_pack_color(chunk->fill) : 0;
+    if (chunk->uniform && fill == work->packed) return;
+    if (job->x0 == 0 && job->y0 == 0 && job->x1 == chunk->w - 1 && job->y1 == chunk->h - 1) {
+        // Whole chunk: becomes uniform (storage is released on the GL thread after upload).
+        chunk->uniform = true;
+        memcpy(&chunk->fill, &work->packed, sizeof(chunk->fill));
+        job->changed = 1;
+        return;
+    }
+    cce_chunk_materialize(work->layer, chunk);
+    uint32_t* row0 = (uint32_t*)(void*)job->chunk->data;
+    const size_t span = (size_t)(job->x1 - job->x0 + 1);
+    for (int ly = job->y0; ly <= job->y1; ly++) {
+        cce_kernels.fill(row0 + (size_t)ly * (size_t)job->chunk->w + (size_t)job->x0, work->packed, span);
+    }
+    job->changed = 1;
+}
+
+static void palette_chunk_job(int index, void* userdata)
+{
+    CCE_ChunkWork* work = userdata;
+    CCE_ChunkJob* job = &work->jobs[index];
+    CCE_Chunk* chunk = job->chunk;
+    const int cs = work->cell_size;
+    const int sx = chunk->x * work->layer->chunk_size;
+    const int sy = chunk->y * work->layer->chunk_size;
+    const int X0 = sx + job->x0, X1 = sx + job->x1;
+    const int Y0 = sy + job->y0, Y1 = sy + job->y1;
+    const int whole = job->x0 == 0 && job->y0 == 0 && job->x1 == chunk->w - 1 && job->y1 == chunk->h - 1;
+    const CCE_BlendMode mode = work->layer->blend_mode;
+    cce_chunk_back(work->layer, chunk, !whole || mode != CCE_BLEND_REPLACE);
+    uint32_t* row0 = (uint32_t*)(void*)chunk->data;
+    uint32_t cells[CCE_CHUNK_SIZE_MAX];
+    uint32_t src[CCE_CHUNK_SIZE_MAX];
+    const size_t span = (size_t)(X1 - X0 + 1);
+
+    // Cells are anchored at the fill origin; a cell cut by the chunk border is evaluated on both sides.
+    const int first_x = work->origin_x + ((X0 - work->origin_x) / cs) * cs;
+    const size_t cell_count = (size_t)((X1 - first_x) / cs + 1);
+    for (int cell_y = work->origin_y + ((Y0 - work->origin_y) / cs) * cs; cell_y <= Y1; cell_y += cs) {
+        const int ry0 = cell_y > Y0 ? cell_y : Y0;
+        const int ry1 = cell_y + cs - 1 < Y1 ? cell_y + cs - 1 : Y1;
+        // One row of cells at a time: noise and palette lookup per cell, then widened to pixels.
+        cce_kernels.palette(cells, work->lut, (uint32_t)(first_x + work->offset_x), (uint32_t)(cell_y + work->offset_y),
+                            (uint32_t)cs, work->seed, cell_count);
+        const uint32_t* line = cells;
+        if (cs > 1) {
+            size_t out = 0;
+            for (size_t c = 0; c < cell_count; c++) {
+                const int bx0 = first_x + (int)c * cs;
+                const int from = bx0 > X0 ? bx0 : X0;
+                const int to = bx0 + cs - 1 < X1 ? bx0 + cs - 1 : X1;
+                const size_t n = (size_t)(to - from + 1);
+                // Narrow cells are cheaper to store inline than through a kernel call.
+                if (n <= 8) for (size_t k = 0; k < n; k++) src[out + k] = cells[c];
+                else cce_kernels.fill(src + out, cells[c], n);
+                out += n;
+            }
+            line = src;
+        }
+        for (int y = ry0; y <= ry1; y++) {
+            uint32_t* dst = row0 + (size_t)(y - sy) * (size_t)chunk->w + (size_t)job->x0;
+            if (mode == CCE_BLEND_REPLACE) cce_kernels.copy(dst, line, span);
+            else cce_blend_span(mode, dst, line, span);
+        }
+    }
+    job->changed = 1;
+}
+
+// Noise field values in [0, 1] index the palette table as noise bytes.
+static void field_chunk_job(int index, void* userdata)
+{
+    CCE_ChunkWork* work = userdata;
+    CCE_ChunkJob* job = &work->jobs[index];
+    CCE_Chunk* chunk = job->chunk;
+    const CCE_NoiseField* field = work->field;
+    const int sx = chunk->x * work->layer->chunk_size;
+    const int sy = chunk->y * work->layer->chunk_size;
+    const int whole = job->x0 == 0 && job->y0 == 0 && job->x1 == chunk->w - 1 && job->y1 == chunk->h - 1;
+    const CCE_BlendMode mode = work->layer->blend_mode;
+    cce_chunk_back(work->layer, chunk, !whole || mode != CCE_BLEND_REPLACE);
+    uint32_t* row0 = (uint32_t*)(void*)chunk->data;
+    uint32_t line[CCE_CHUNK_SIZE_MAX];
+    const size_t span = (size_t)(job->x1 - job->x0 + 1);
+
+    for (int ly = job->y0; ly <= job->y1; ly++) {
+        const float* values = field->values + (size_t)(sy + ly - work->origin_y) * (size_t)field->w
+                            + (size_t)(sx + job->x0 - work->origin_x);
+        for (size_t i = 0; i < span; i++) {
+            const float v = values[i] < 0.0f ? 0.0f : values[i] > 1.0f ? 1.0f : values[i];
+            line[i] = work->lut[(int)(v * 255.0f)];
+        }
+        uint32_t* dst = row0 + (size_t)ly * (size_t)chunk->w + (size_t)job->x0;
+        if (mode == CCE_BLEND_REPLACE) cce_kernels.copy(dst, line, span);
+        else cce_blend_span(mode, dst, line, span);
+    }
+    job->changed = 1;
+}
+
+// Clips [x0..x1]x[y0..y1] (either corner order) to the layer; returns 0 if nothing is left.
+static int clip_rect(const CCE_Layer* layer, int* x0, int* y0, int* x1, int* y1)
+{
+    if (*x0 > *x1) { int t = *x0; *x0 = *x1; *x1 = t; }
+    if (*y0 > *y1) { int t = *y0; *y0 = *y1; *y1 = t; }
+    if (*x0 < 0) *x0 = 0;
+    if (*y0 < 0) *y0 = 0;
+    if (*x1 >= layer->scr_w) *x1 = layer->scr_w - 1;
+    if (*y1 >= layer->scr_h) *y1 = layer->scr_h - 1;
+    return *x0 <= *x1 && *y0 <= *y1;
+}
+
+int cce_layer_parallel_for_chunks(CCE_Layer* layer, CCE_ChunkFn fn, void* userdata)
+{
+    if (!layer || !fn || layer->backend != CCE_LAYER_CPU) {
+        ERRLOG;
+        return -1;
+    }
+
+    int count = 0;
+    CCE_ChunkJob* jobs = collect_chunk_jobs(layer, 0, 0, layer->scr_w - 1, layer->scr_h - 1, &count);
+    if (!jobs) return -1;
+
+    CCE_ChunkWork work = { .layer = layer, .jobs = jobs, .fn = fn, .userdata = userdata };
+    // User callbacks are assumed heavy enough to always go wide.
+    run_chunk_jobs(layer, &work, count, CCE_PARALLEL_MIN_PIXELS, user_chunk_job);
+    free(jobs);
+    return 0;
+}
+
+void cce_set_pixel_rect_parallel(CCE_Layer* layer, int x0, int y0, int x1, int y1, CCE_Color color)
 {
     if (!layer) return;
-    if (!layer->has_dirty) return;
-    
-    glBindTexture(GL_TEXTURE_2D, layer->texture);
-    
-    int updated = 0;
-    
-    // Собираем список грязных чанков
-    enum { DIRTY_CAP = 1024 };
-    CCE_Chunk* dirty_chunks[DIRTY_CAP];  // Максимум DIRTY_CAP чанков за кадр
-    int dirty_count = 0;
-    int has_more = 0;
-    
-    for (int y = 0; y < layer->chunk_count_y; y++) {
-        for (int x = 0; x < layer->chunk_count_x; x++) {
-            CCE_Chunk* chunk = layer->chunks[y][x];
-            
-            if (chunk->dirty && chunk->visible) {
-                if (dirty_count < DIRTY_CAP) {
-                    dirty_chunks[dirty_count++] = chunk;
-                } else {
-                    has_more = 1;
-                }
+    if (layer->backend == CCE_LAYER_GPU) {
+        cce_set_pixel_rect(layer, x0, y0, x1, y1, color);
+        return;
+    }
+    if (!clip_rect(layer, &x0, &y0, &x1, &y1)) return;
+
+    int count = 0;
+    CCE_ChunkJob* jobs = collect_chunk_jobs(layer, x0, y0, x1, y1, &count);
+    if (!jobs) return;
+
+    CCE_ChunkWork work = { .layer = layer, .jobs = jobs, .packed = cce_pack_color(color) };
+    run_chunk_jobs(layer, &work, count, (long)(x1 - x0 + 1) * (long)(y1 - y0 + 1), fill_chunk_job);
+    free(jobs);
+}
+
+void cce_fill_palette_rect(CCE_Layer* layer, int x0, int y0, int x1, int y1, int cell_size,
+                           int offset_x, int offset_y, CCE_Palette palette, ...)
+{
+    if (!layer || cell_size < 1) return;
+
+    // Palettes without noise give one colour for the whole rect (and may read varargs).
+    if (palette != DefaultGrass && palette != DefaultStone && palette != DefaultCloud) {
+        va_list args;
+        va_start(args, palette);
+        CCE_Color color = get_color_va(0, 0, 0, 0, palette, args);
+        va_end(args);
+        cce_set_pixel_rect_parallel(layer, x0, y0, x1, y1, color);
+        return;
+    }
+
+    if (x0 > x1) { int t = x0; x0 = x1; x1 = t; }
+    if (y0 > y1) { int t = y0; y0 = y1; y1 = t; }
+    const int origin_x = x0;
+    const int origin_y = y0;
+
+    if (layer->backend == CCE_LAYER_GPU) {
+        for (int cell_y = origin_y; cell_y <= y1; cell_y += cell_size) {
+            for (int cell_x = origin_x; cell_x <= x1; cell_x += cell_size) {
+                const int cx1 = cell_x + cell_size - 1 < x1 ? cell_x + cell_size - 1 : x1;
+                const int cy1 = cell_y + cell_size - 1 < y1 ? cell_y + cell_size - 1 : y1;
+                cce_set_pixel_rect(layer, cell_x, cell_y, cx1, cy1,
+                                   cce_get_color(cell_x, cell_y, offset_x, offset_y, palette));
             }
         }
+        return;
     }
-    
-    // Обновляем чанки через PBO (асинхронно)
-    for (int i = 0; i < dirty_count; i++) {
-        CCE_Chunk* chunk = dirty_chunks[i];
-        
-        int screen_x = chunk->x * layer->chunk_size;
-        int screen_y = chunk->y * layer->chunk_size;
-        
-        int chunk_data_size = chunk->w * chunk->h * 4;  // RGBA
-        
-        // Если размер чанка больше PBO, используем прямой метод
-        if (chunk_data_size > layer->pbo_size) {
-            // Fallback на синхронный метод для больших чанков
-            glTexSubImage2D(GL_TEXTURE_2D, 0,
-                           screen_x, screen_y,
-                           chunk->w, chunk->h,
-                           GL_RGBA, GL_UNSIGNED_BYTE,
-                           chunk->data);
-        } else {
-            // Переключаемся на следующий PBO (двойная буферизация)
-            layer->current_pbo_index = (layer->current_pbo_index + 1) % 2;
-            int pbo_index = layer->pbo_ids[layer->current_pbo_index];
-            
-            // Привязываем PBO
-            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_index);
-            
-            // Записываем данные в PBO
-            glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, chunk_data_size, chunk->data);
-            
-            // Загружаем из PBO в текстуру (асинхронная операция!)
-            // offset = 0, потому что мы записали данные в начало PBO
-            glTexSubImage2D(GL_TEXTURE_2D, 0,
-                           screen_x, screen_y,
-                           chunk->w, chunk->h,
-                           GL_RGBA, GL_UNSIGNED_BYTE,
-                           0);  // offset = 0, данные берутся из привязанного PBO
-            
-            // Отвязываем PBO
-            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (!clip_rect(layer, &x0, &y0, &x1, &y1)) return;
+
+    int count = 0;
+    CCE_ChunkJob* jobs = collect_chunk_jobs(layer, x0, y0, x1, y1, &count);
+    if (!jobs) return;
+
+    // The noise palettes map the noise byte alone, so the mapping is tabulated once per call.
+    uint32_t lut[256];
+    for (int n = 0; n < 256; n++) lut[n] = cce_pack_color(palette_color(palette, n));
+
+    CCE_ChunkWork work = {
+        .layer = layer,
+        .jobs = jobs,
+        .origin_x = origin_x,
+        .origin_y = origin_y,
+        .cell_size = cell_size,
+        .offset_x = offset_x,
+        .offset_y = offset_y,
+        .seed = (uint32_t)(engine_seed + palette),
+        .lut = lut,
+    };
+    run_chunk_jobs(layer, &work, count, (long)(x1 - x0 + 1) * (long)(y1 - y0 + 1), palette_chunk_job);
+    free(jobs);
+}
+
+int cce_fill_noise_field(CCE_Layer* layer, int x, int y, const CCE_NoiseField* field, CCE_Palette palette)
+{
+    if (!layer || !field || !field->values || field->w < 1 || field->h < 1 ||
+        (palette != DefaultGrass && palette != DefaultStone && palette != DefaultCloud)) {
+        ERRLOG;
+        return -1;
+    }
+
+    uint32_t lut[256];
+    for (int n = 0; n < 256; n++) lut[n] = cce_pack_color(palette_color(palette, n));
+
+    if (layer->backend == CCE_LAYER_GPU) {
+        for (int r = 0; r < field->h; r++) {
+            for (int c = 0; c < field->w; c++) {
+                float v = field->values[(size_t)r * (size_t)field->w + (size_t)c];
+                v = v < 0.0f ? 0.0f : v > 1.0f ? 1.0f : v;
+                cce_set_pixel(layer, x + c, y + r, palette_color(palette, (int)(v * 255.0f)));
+            }
         }
-        
-        chunk->dirty = false;
-        updated++;
+        return 0;
+    }
+
+    int x0 = x, y0 = y;
+    int x1 = x + field->w - 1, y1 = y + field->h - 1;
+    if (!clip_rect(layer, &x0, &y0, &x1, &y1)) return 0;
+
+    int count = 0;
+    CCE_ChunkJob* jobs = collect_chunk_jobs(layer, x0, y0, x1, y1, &count);
+    if (!jobs) return -1;
+
+    CCE_ChunkWork work = {
+        .layer = layer,
+        .jobs = jobs,
+        .origin_x = x,
+        .origin_y = y,
+        .lut = lut,
+        .field = field,
+    };
+    run_chunk_jobs(layer, &work, count, (long)(x1 - x0 + 1) * (long)(y1 - y0 + 1), field_chunk_job);
+    free(jobs);
+    return 0;
+}
+
+// One write after bucketing: chunk-local position and packed colour.
+typedef struct CCE_ScatterWrite
+{
+    uint16_t lx, ly;
+    uint32_t color;
+} CCE_ScatterWrite;
+
+// Scratch reused across calls; scatter writes run on the drawing thread only.
+static uint32_t* g_scatter_keys = NULL;   // chunk index per write, UINT32_MAX when clipped
+static uint32_t* g_scatter_locals = NULL; // chunk-local x | y << 16
+static CCE_ScatterWrite* g_scatter_sorted = NULL;
+static size_t g_scatter_cap = 0;
+static size_t* g_scatter_counts = NULL;
+static size_t g_scatter_counts_cap = 0;
+
+static void scatter_chunk_job(int index, void* userdata)
+{
+    CCE_ChunkWork* work = userdata;
+    CCE_ChunkJob* job = &work->jobs[index];
+    CCE_Chunk* chunk = job->chunk;
+    const CCE_ScatterWrite* w = work->scatter + work->scatter_start[index];
+    const CCE_ScatterWrite* end = work->scatter + work->scatter_start[index + 1];
+    const CCE_BlendMode mode = work->layer->blend_mode;
+
+    if (chunk->uniform && mode == CCE_BLEND_REPLACE) {
+        const uint32_t fill = cce_pack_color(chunk->fill);
+        const CCE_ScatterWrite* p = w;
+        while (p < end && p->color == fill) p++;
+        if (p == end) return;
+    }
+    cce_chunk_materialize(work->layer, chunk);
+
+    uint32_t* pixels = (uint32_t*)(void*)chunk->data;
+    int x0 = chunk->w, y0 = chunk->h, x1 = 0, y1 = 0;
+    for (; w < end; w++) {
+        uint32_t* dst = pixels + (size_t)w->ly * (size_t)chunk->w + w->lx;
+        *dst = mode == CCE_BLEND_REPLACE ? w->color : cce_blend_pixel(mode, w->color, *dst);
+        if (w->lx < x0) x0 = w->lx;
+        if (w->lx > x1) x1 = w->lx;
+        if (w->ly < y0) y0 = w->ly;
+        if (w->ly > y1) y1 = w->ly;
     }
+    job->x0 = x0;
+    job->y0 = y0;
+    job->x1 = x1;
+    job->y1 = y1;
+    job->changed = 1;
+}
 
-    if (updated > 0 && CCE_DEBUG == 1) {
-        cce_printf("Dirty chunks updated: %d/%d on %s\n", 
-                   updated, layer->chunk_count_x * layer->chunk_count_y, layer->name);
+// Counting sort of the writes by chunk index (stable, so later writes to a pixel still win),
+// then one job per touched chunk.
+static void set_pixels(CCE_Layer* layer, const CCE_PixelWrite* writes, size_t count, int parallel)
+{
+    if (!layer || !writes || count == 0) return;
+    if (layer->backend == CCE_LAYER_GPU) {
+        for (size_t i = 0; i < count; i++) cce_set_pixel(layer, writes[i].x, writes[i].y, writes[i].color);
+        return;
     }
 
-    // If we found no remaining dirty chunks (or we updated all of them), we can skip scanning next frame.
-    if (!has_more && dirty_count == 0) {
-        layer->has_dirty = false;
-    } else if (!has_more && dirty_count > 0) {
-        // We scanned full layer and updated all dirty chunks we saw; no more remain.
-        layer->has_dirty = false;
+    const size_t chunk_total = (size_t)layer->chunk_count_x * (size_t)layer->chunk_count_y;
+    if (count > g_scatter_cap) {
+        uint32_t* keys = realloc(g_scatter_keys, count * sizeof(uint32_t));
+        if (keys) g_scatter_keys = keys;
+        uint32_t* locals = realloc(g_scatter_locals, count * sizeof(uint32_t));
+        if (locals) g_scatter_locals = locals;
+        CCE_ScatterWrite* sorted = realloc(g_scatter_sorted, count * sizeof(CCE_ScatterWrite));
+        if (sorted) g_scatter_sorted = sorted;
+        if (!keys || !locals || !sorted) {
+            ERRLOG;
+            return;
+        }
+        g_scatter_cap = count;
+    }
+    if (chunk_total + 1 > g_scatter_counts_cap) {
+        size_t* counts = realloc(g_scatter_counts, (chunk_total + 1) * sizeof(size_t));
+        if (!counts) {
+            ERRLOG;
+            return;
+        }
+        g_scatter_counts = counts;
+        g_scatter_counts_cap = chunk_total + 1;
+    }
+
+    size_t* counts = g_scatter_counts;
+    uint32_t* keys = g_scatter_keys;
+    uint32_t* locals = g_scatter_locals;
+    memset(counts, 0, (chunk_total + 1) * sizeof(size_t));
+    // Chunk coordinates by multiply-shift instead of a divide per axis: exact while x < 2^32 / chunk_size.
+    const uint32_t cs = (uint32_t)layer->chunk_size;
+    const uint64_t recip = ((uint64_t)1 << 32) / cs + 1;
+    for (size_t i = 0; i < count; i++) {
+        const int x = writes[i].x, y = writes[i].y;
+        if ((unsigned)x >= (unsigned)layer->scr_w || (unsigned)y >= (unsigned)layer->scr_h) {
+            keys[i] = UINT32_MAX;
+            continue;
+        }
+        const uint32_t cx = (uint32_t)(((uint64_t)(uint32_t)x * recip) >> 32);
+        const uint32_t cy = (uint32_t)(((uint64_t)(uint32_t)y * recip) >> 32);
+        keys[i] = cy * (uint32_t)layer->chunk_count_x + cx;
+        locals[i] = ((uint32_t)x - cx * cs) | ((uint32_t)y - cy * cs) << 16;
+        counts[keys[i] + 1]++;
+    }
+
+    int jobs_count = 0;
+    for (size_t c = 0; c < chunk_total; c++) {
+        if (counts[c + 1]) jobs_count++;
+        counts[c + 1] += counts[c];
+    }
+    if (jobs_count == 0) return;
+
+    CCE_ChunkJob* jobs = malloc((size_t)jobs_count * sizeof(CCE_ChunkJob));
+    size_t* starts = malloc(((size_t)jobs_count + 1) * sizeof(size_t));
+    if (!jobs || !starts) {
+        free(jobs);
+        free(starts);
+        ERRLOG;
+        return;
+    }
+    int n = 0;
+    for (size_t c = 0; c < chunk_total; c++) {
+        if (counts[c + 1] == counts[c]) continue;
+        jobs[n].chunk = &layer->chunks[c];
+        jobs[n].changed = 0;
+        starts[n++] = counts[c];
+    }
+    starts[n] = counts[chunk_total];
+
+    // counts[c] now walks bucket c forward.
+    CCE_ScatterWrite* sorted = g_scatter_sorted;
+    for (size_t i = 0; i < count; i++) {
+        if (keys[i] == UINT32_MAX) continue;
+        CCE_ScatterWrite* out = &sorted[counts[keys[i]]++];
+        out->lx = (uint16_t)locals[i];
+        out->ly = (uint16_t)(locals[i] >> 16);
+        out->color = cce_pack_color(writes[i].color);
+    }
+
+    CCE_ChunkWork work = { .layer = layer, .jobs = jobs, .scatter = sorted, .scatter_start = starts };
+    run_chunk_jobs(layer, &work, jobs_count, parallel ? (long)count : 0, scatter_chunk_job);
+    free(jobs);
+    free(starts);
+}
+
+void cce_set_pixels(CCE_Layer* layer, const CCE_PixelWrite* writes, size_t count)
+{
+    set_pixels(layer, writes, count, 0);
+}
+
+void cce_set_pixels_parallel(CCE_Layer* layer, const CCE_PixelWrite* writes, size_t count)
+{
+    set_pixels(layer, writes, count, 1);
+}
+
+static size_t chunk_upload_bytes(const CCE_Chunk* chunk)
+{
+    const size_t w = (size_t)(chunk->dirty_x1 - chunk->dirty_x0 + 1);
+    const size_t h = (size_t)(chunk->dirty_y1 - chunk->dirty_y0 + 1);
+    return w * h * sizeof(CCE_Color);
+}
+
+static size_t texture_rect_bytes(const CCE_TextureRect* rect)
+{
+    return (size_t)rect->w * (size_t)rect->h * sizeof(CCE_Color);
+}
+
+// Copies the rect's pixels into `dst` as tightly packed rows.
+static void pack_texture_rect(const CCE_TextureRect* rect, unsigned char* dst)
+{
+    if (!rect->pixels) {
+        cce_kernels.fill((uint32_t*)(void*)dst, cce_pack_color(rect->fill), texture_rect_bytes(rect) / sizeof(CCE_Color));
+        return;
+    }
+    const size_t row_bytes = (size_t)rect->w * sizeof(CCE_Color);
+    const CCE_Color* src = rect->pixels;
+    if (rect->w == rect->stride) {
+        memcpy(dst, src, row_bytes * (size_t)rect->h);
+        return;
+    }
+    for (int y = 0; y < rect->h; y++) {
+        memcpy(dst, src, row_bytes);
+        dst += row_bytes;
+        src += rect->stride;
+    }
+}
+
+static void upload_texture_rect(const CCE_TextureRect* rect, const void* pixels)
+{
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect->x, rect->y, rect->w, rect->h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+}
+
+// Larger than an arena region: uploads straight from client memory.
+static void upload_texture_rect_direct(const CCE_TextureRect* rect)
+{
+    if (!rect->pixels) {
+        unsigned char* fill = malloc(texture_rect_bytes(rect));
+        if (!fill) {
+            ERRLOG;
+            return;
+        }
+        pack_texture_rect(rect, fill);
+        upload_texture_rect(rect, fill);
+        free(fill);
+        return;
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, rect->stride);
+    upload_texture_rect(rect, rect->pixels);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+int cce_upload_texture_rects(unsigned int texture, const CCE_TextureRect* rects, int count)
+{
+    if (count <= 0) return 0;
+    if (stream_create(&g_upload) != 0) return -1;
+    if (g_clear_texture < 0) g_clear_texture = gl_has_feature(4, 4, "GL_ARB_clear_texture");
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    // Clear path: solid rects never touch the upload arena.
+    if (g_clear_texture) {
+        for (int i = 0; i < count; i++) {
+            const CCE_TextureRect* rect = &rects[i];
+            if (rect->pixels) continue;
+            glClearTexSubImage(texture, 0, rect->x, rect->y, 0, rect->w, rect->h, 1,
+                               GL_RGBA, GL_UNSIGNED_BYTE, &rect->fill);
+        }
+    }
+
+    int i = 0;
+    while (i < count) {
+        if (g_clear_texture && !rects[i].pixels) {
+            i++;
+            continue;
+        }
+        size_t avail = 0;
+        unsigned char* dst = stream_begin(&g_upload, texture_rect_bytes(&rects[i]), &avail);
+        if (!dst) {
+            upload_texture_rect_direct(&rects[i++]);
+            continue;
+        }
+
+        // Pack pass.
+        size_t used = 0;
+        int end = i;
+        for (; end < count; end++) {
+            if (g_clear_texture && !rects[end].pixels) continue;
+            const size_t bytes = texture_rect_bytes(&rects[end]);
+            if (used + bytes > avail) break;
+            pack_texture_rect(&rects[end], dst + used);
+            used += bytes;
+        }
+
+        // Upload pass: every rect reads from its own offset, nothing is reused within the frame.
+        size_t at = stream_end(&g_upload, used);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, g_upload.buffer);
+        for (; i < end; i++) {
+            if (g_clear_texture && !rects[i].pixels) continue;
+            upload_texture_rect(&rects[i], (const void*)at);
+            at += texture_rect_bytes(&rects[i]);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    return 0;
+}
+
+// Computes the chunk's content hash into *hash; returns 1 if the GPU already holds exactly these pixels.
+static int chunk_unchanged(const CCE_Layer* layer, const CCE_Chunk* chunk, uint64_t* hash)
+{
+    *hash = 0;
+    if (!layer->hash_uploads) return 0;
+
+    // After any upload the whole chunk matches the texture, so the full chunk is hashed, not the dirty rect.
+    if (chunk->uniform) {
+        // Uniform chunks hash their colour only; a backed chunk with the same pixels simply uploads once more.
+        *hash = (uint64_t)cce_pack_color(chunk->fill) * 0x9E3779B97F4A7C15ull;
     } else {
-        // Some dirty chunks remain beyond our cap.
-        layer->has_dirty = true;
+        *hash = cce_kernels.hash((const uint32_t*)(const void*)chunk->data, (size_t)chunk->w * (size_t)chunk->h, 0);
     }
+    return chunk->upload_hash_valid && chunk->upload_hash == *hash;
+}
+
+// Grows the upload_chunks scratch to hold `count` chunks.
+static int upload_scratch_reserve(int count)
+{
+    if (count <= g_upload_rects_cap) return 0;
+    CCE_TextureRect* rects = realloc(g_upload_rects, (size_t)count * sizeof(CCE_TextureRect));
+    if (!rects) return -1;
+    g_upload_rects = rects;
+    uint64_t* hashes = realloc(g_upload_hashes, (size_t)count * sizeof(uint64_t));
+    if (!hashes) return -1;
+    g_upload_hashes = hashes;
+    g_upload_rects_cap = count;
+    return 0;
+}
+
+// Uploads a NULL-terminated dirty_next list of chunks through cce_upload_texture_rects, then
+// records their hashes[] and upload stats and marks them clean. Uniform chunks hand their pages
+// back afterwards. Returns -1 with every chunk left dirty if nothing could be sent.
+static int upload_chunks(CCE_Layer* layer, CCE_Chunk* chunks, const uint64_t* hashes)
+{
+    int n = 0;
+    for (CCE_Chunk* chunk = chunks; chunk; chunk = chunk->dirty_next) {
+        CCE_TextureRect* rect = &g_upload_rects[n++];
+        rect->x = chunk->x * layer->chunk_size + chunk->dirty_x0;
+        rect->y = chunk->y * layer->chunk_size + chunk->dirty_y0;
+        rect->w = chunk->dirty_x1 - chunk->dirty_x0 + 1;
+        rect->h = chunk->dirty_y1 - chunk->dirty_y0 + 1;
+        rect->pixels = chunk->uniform ? NULL : chunk->data + (size_t)chunk->dirty_y0 * (size_t)chunk->w + (size_t)chunk->dirty_x0;
+        rect->stride = chunk->w;
+        rect->fill = chunk->fill;
+    }
+    if (n == 0) return 0;
+    if (cce_upload_texture_rects(layer->texture, g_upload_rects, n) != 0) return -1;
+
+    n = 0;
+    for (CCE_Chunk* chunk = chunks; chunk; chunk = chunk->dirty_next) {
+        chunk->upload_hash = hashes[n++];
+        chunk->upload_hash_valid = layer->hash_uploads;
+        layer->upload_stats.uploaded_bytes += chunk_upload_bytes(chunk);
+        layer->upload_stats.uploaded_chunks++;
+        chunk->dirty = false;
+        chunk_release(layer, chunk);
+    }
+    return 0;
+}
+
+void update_dirty_chunks(CCE_Layer* layer)
+{
+    if (!layer) return;
+    if (!layer->has_dirty) return;
+    if (upload_scratch_reserve(layer->dirty_count) != 0) {
+        ERRLOG;
+        return;
+    }
+
+    // Забираем очередь целиком; скрытые чанки остаются грязными до следующего кадра.
+    CCE_Chunk* queue = layer->dirty_head;
+    const int queued = layer->dirty_count;
+    layer->dirty_head = NULL;
+    layer->dirty_tail = NULL;
+    layer->dirty_count = 0;
+
+    CCE_Chunk* upload_head = NULL;
+    CCE_Chunk* upload_tail = NULL;
+    CCE_Chunk** upload_link = &upload_head;
+    CCE_Chunk* kept_tail = NULL;
+    int dirty_count = 0;
+    while (queue) {
+        CCE_Chunk* chunk = queue;
+        queue = chunk->dirty_next;
+        chunk->dirty_next = NULL;
+        if (!chunk->visible) {
+            if (kept_tail) kept_tail->dirty_next = chunk;
+            else layer->dirty_head = chunk;
+            kept_tail = chunk;
+            layer->dirty_count++;
+            continue;
+        }
+
+        uint64_t hash;
+        if (chunk_unchanged(layer, chunk, &hash)) {
+            layer->upload_stats.skipped_bytes += chunk_upload_bytes(chunk);
+            layer->upload_stats.skipped_chunks++;
+            chunk->dirty = false;
+            chunk_release(layer, chunk);
+            continue;
+        }
+        g_upload_hashes[dirty_count] = hash;
+        *upload_link = chunk;
+        upload_link = &chunk->dirty_next;
+        upload_tail = chunk;
+        dirty_count++;
+    }
+    layer->dirty_tail = kept_tail;
+
+    if (upload_chunks(layer, upload_head, g_upload_hashes) != 0) {
+        // Chunks stay dirty, so mark_dirty would never queue them again: put them back for the next frame.
+        if (layer->dirty_tail) layer->dirty_tail->dirty_next = upload_head;
+        else layer->dirty_head = upload_head;
+        layer->dirty_tail = upload_tail;
+        layer->dirty_count += dirty_count;
+    }
+
+    if (dirty_count > 0 && CCE_DEBUG == 1) {
+        cce_printf("Dirty chunks updated: %d/%d (queued %d) on %s\n",
+                   dirty_count, layer->chunk_count_x * layer->chunk_count_y, queued, layer->name);
+    }
+
+    layer->has_dirty = layer->dirty_head ? true : false;
+}
+
+#define CCE_CALIBRATE_FRAMES 8
+
+static double calibrate_now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int cce_calibrate_chunk_size(int screen_w, int screen_h)
+{
+    static const int candidates[] = { 64, 128, CHUNK_SIZE, 256, 512 };
+    int best = engine_chunk_size;
+    double best_time = 0.0;
+
+    if (screen_w <= 0 || screen_h <= 0) {
+        ERRLOG;
+        return best;
+    }
+
+    for (size_t c = 0; c < sizeof(candidates) / sizeof(candidates[0]); c++) {
+        const int size = candidates[c];
+        CCE_Layer* layer = cce_layer_cpu_create_ex(screen_w, screen_h, "calibrate", size);
+        if (!layer) continue;
+
+        // Первая загрузка (очистка текстуры) не измеряется
+        update_dirty_chunks(layer);
+        cce_render_end_frame();
+        glFinish();
+
+        // Same pseudo-random workload for every candidate: scattered pixels plus small and large rects.
+        uint32_t seed = 0x2545F491u;
+        const double start = calibrate_now();
+        for (int frame = 0; frame < CCE_CALIBRATE_FRAMES; frame++) {
+            for (int i = 0; i < 2048; i++) {
+                seed = seed * 1664525u + 1013904223u;
+                const CCE_Color color = { seed >> 24, seed >> 16, seed >> 8, 255 };
+                cce_set_pixel(layer, (int)((seed >> 4) % (uint32_t)screen_w), (int)((seed >> 12) % (uint32_t)screen_h), color);
+            }
+            for (int i = 0; i < 32; i++) {
+                seed = seed * 1664525u + 1013904223u;
+                const int x = (int)((seed >> 4) % (uint32_t)screen_w);
+                const int y = (int)((seed >> 12) % (uint32_t)screen_h);
+                const CCE_Color color = { seed >> 24, seed >> 16, 64, 255 };
+                cce_set_pixel_rect(layer, x, y, x + 47, y + 31, color);
+            }
+            cce_set_pixel_rect(layer, screen_w / 8, screen_h / 8, screen_w / 2 + frame, screen_h / 2, (CCE_Color){ 32, frame * 16, 96, 255 });
+
+            update_dirty_chunks(layer);
+            cce_render_end_frame();
+            glFinish();
+        }
+        const double elapsed = (calibrate_now() - start) / CCE_CALIBRATE_FRAMES;
+        cce_layer_destroy(layer);
+
+        cce_printf("Chunk %4dpx: %.3f ms/frame\n", size, elapsed * 1000.0);
+        if (best_time == 0.0 || elapsed < best_time) {
+            best_time = elapsed;
+            best = size;
+        }
+    }
+
+    cce_printf("Recommended chunk size: %d\n", best);
+    return best;
 }
 
 void render_layer(CCE_Layer* layer)
 {
     if (!layer) return;
     if (ensure_quad_pipeline() != 0) return;
+    batch_submit();
 
     if (layer->backend == CCE_LAYER_CPU) {
         update_dirty_chunks(layer);
@@ -977,6 +2304,7 @@ void render_pie(CCE_Layer** layers, int count)
 {
     if (!layers || count <= 0) return;
     if (ensure_quad_pipeline() != 0) return;
+    batch_submit();
 
     for (int i = 0; i < count; i++) {
         if (!layers[i] || !layers[i]->enabled) continue;
@@ -1039,19 +2367,17 @@ void cce_layer_destroy(CCE_Layer* layer)
     if (g_active_layer == layer) {
         (void)cce_layer_end(layer);
     }
+    // Pending quads may still sample this layer's texture.
+    batch_submit();
 
     if (layer->backend == CCE_LAYER_CPU) {
-        if (layer->pbo_ids[0] != 0 || layer->pbo_ids[1] != 0) {
-            glDeleteBuffers(2, layer->pbo_ids);
-        }
-        for (int y = 0; y < layer->chunk_count_y; y++) {
-            for (int x = 0; x < layer->chunk_count_x; x++) {
-                free(layer->chunks[y][x]->data);
-                free(layer->chunks[y][x]);
-            }
-            free(layer->chunks[y]);
+        // Snapshots outlive the layer: give them their own copies first.
+        const int chunk_count = layer->chunk_count_x * layer->chunk_count_y;
+        for (int i = 0; i < chunk_count; i++) {
+            if (layer->chunks[i].shared) cce_chunk_unshare(&layer->chunks[i]);
         }
-        free(layer->chunks);
+        // Headers and pixels share one arena.
+        munmap(layer->chunks, layer->arena_bytes);
     } else {
         if (layer->fbo) {
             GLuint f = (GLuint)layer->fbo;
@@ -1136,28 +2462,37 @@ void test_simple()
     free(pixels);
 }
 
-CCE_Color cce_get_color(int pos_x, int pos_y, int offset_x, int offset_y, CCE_Palette palette, ...)
+static CCE_Color get_color_va(int pos_x, int pos_y, int offset_x, int offset_y, CCE_Palette palette, va_list args)
+{
+    const pct noise = (pct)cce_noise_byte((uint32_t)(pos_x + offset_x), (uint32_t)(pos_y + offset_y),
+                                          (uint32_t)(engine_seed + palette));
+    return palette_color_va(palette, noise, args);
+}
+
+static CCE_Color palette_color(CCE_Palette palette, int noise, ...)
+{
+    va_list args;
+    va_start(args, noise);
+    CCE_Color ret = palette_color_va(palette, (pct)noise, args);
+    va_end(args);
+    return ret;
+}
+
+static CCE_Color palette_color_va(CCE_Palette palette, pct noise, va_list args)
 {
     CCE_Color ret;
-    pct noise = (pct) ((procedural_noise(pos_x + offset_x, pos_y + offset_y, engine_seed + palette)) * 255);
 
     switch (palette)
     {
         case Shadow:
-            va_list shadow;
-            va_start(shadow, palette);
-            ret.a = (pct) va_arg(shadow, int);
-            va_end(shadow);
+            ret.a = (pct) va_arg(args, int);
             ret.r = 0;
             ret.g = 0;
             ret.b = 0;
             break;
 
         case Alpha:
-            va_list alpha;
-            va_start(alpha, palette);
-            ret.a = (pct) va_arg(alpha, int);
-            va_end(alpha);
+            ret.a = (pct) va_arg(args, int);
             ret.r = 255;
             ret.g = 255;
             ret.b = 255;
@@ -1199,13 +2534,10 @@ CCE_Color cce_get_color(int pos_x, int pos_y, int offset_x, int offset_y, CCE_Pa
             break;
             
         case Manual:
-            va_list rgb;
-            va_start(rgb, palette);
-            ret.r = (pct) va_arg(rgb, int);
-            ret.g = (pct) va_arg(rgb, int);
-            ret.b = (pct) va_arg(rgb, int);
-            ret.a = (pct) va_arg(rgb, int);
-            va_end(rgb);
+            ret.r = (pct) va_arg(args, int);
+            ret.g = (pct) va_arg(args, int);
+            ret.b = (pct) va_arg(args, int);
+            ret.a = (pct) va_arg(args, int);
             break;
 
         case DefaultGrass:
@@ -1274,3 +2606,11 @@ CCE_Color cce_get_color(int pos_x, int pos_y, int offset_x, int offset_y, CCE_Pa
     return ret;
 }
 
+CCE_Color cce_get_color(int pos_x, int pos_y, int offset_x, int offset_y, CCE_Palette palette, ...)
+{
+    va_list args;
+    va_start(args, palette);
+    CCE_Color ret = get_color_va(pos_x, pos_y, offset_x, offset_y, palette, args);
+    va_end(args);
+    return ret;
+}
@@ -29,7 +29,145 @@ SOFTWARE.
 
 #include "../engine.h"
 
+#include <stdint.h>
+
 float procedural_noise(int x, int y, int seed);
+
+#define CCE_CHUNK_ALIGN 64
+#define CCE_ALIGN_UP(v, a) (((v) + ((a) - 1)) & ~((size_t)(a) - 1))
+
+static inline CCE_Chunk* cce_layer_chunk(const CCE_Layer* layer, int chunk_x, int chunk_y)
+{
+    return &layer->chunks[(size_t)chunk_y * (size_t)layer->chunk_count_x + (size_t)chunk_x];
+}
+
+// Chunk column/row holding screen coordinate v >= 0; power-of-two chunk sizes shift instead of divide.
+static inline int cce_chunk_index(const CCE_Layer* layer, int v)
+{
+    return layer->chunk_shift ? v >> layer->chunk_shift : v / layer->chunk_size;
+}
+
+// Offset of screen coordinate v >= 0 inside its chunk.
+static inline int cce_chunk_local(const CCE_Layer* layer, int v)
+{
+    return layer->chunk_shift ? v & (layer->chunk_size - 1) : v % layer->chunk_size;
+}
+
+// Marks chunk-local rect [x0..x1]x[y0..y1] (inclusive) as changed, merging with the
+// chunk's pending dirty bounds. A chunk that was clean is appended to the layer's dirty queue.
+static inline void cce_chunk_mark_dirty(CCE_Layer* layer, CCE_Chunk* chunk, int x0, int y0, int x1, int y1)
+{
+    if (!chunk->dirty) {
+        chunk->dirty = true;
+        chunk->dirty_x0 = x0;
+        chunk->dirty_y0 = y0;
+        chunk->dirty_x1 = x1;
+        chunk->dirty_y1 = y1;
+        chunk->dirty_next = NULL;
+        if (layer->dirty_tail) {
+            layer->dirty_tail->dirty_next = chunk;
+        } else {
+            layer->dirty_head = chunk;
+        }
+        layer->dirty_tail = chunk;
+        layer->dirty_count++;
+    } else {
+        if (x0 < chunk->dirty_x0) chunk->dirty_x0 = x0;
+        if (y0 < chunk->dirty_y0) chunk->dirty_y0 = y0;
+        if (x1 > chunk->dirty_x1) chunk->dirty_x1 = x1;
+        if (y1 > chunk->dirty_y1) chunk->dirty_y1 = y1;
+    }
+    layer->has_dirty = true;
+    layer->shader_dirty = 1;
+}
+
+static inline int cce_color_equal(CCE_Color a, CCE_Color b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+// Mode a solid colour is really written with: opaque source-over is a plain overwrite.
+static inline CCE_BlendMode cce_solid_blend_mode(const CCE_Layer* layer, uint32_t packed)
+{
+    if (layer->blend_mode == CCE_BLEND_ALPHA && (packed >> 24) == 255) return CCE_BLEND_REPLACE;
+    return layer->blend_mode;
+}
+
+// Chunk pixels held by layer snapshots. Right after a snapshot they are still the chunk's own slot
+// (`slot`, with `chunk->shared` pointing here); the first write to the chunk copies them into `pixels`.
+typedef struct CCE_ChunkBuffer
+{
+    int refs;               // snapshots plus the live chunk while slot-backed
+    int w, h;
+    const CCE_Color* slot;
+    CCE_Color* pixels;
+    unsigned mark;          // scratch for walks that must count each buffer once
+} CCE_ChunkBuffer;
+
+static inline const CCE_Color* cce_chunk_buffer_pixels(const CCE_ChunkBuffer* buffer)
+{
+    return buffer->slot ? buffer->slot : buffer->pixels;
+}
+
+// Detaches `chunk` from its snapshot buffer, copying the pixels out if a snapshot still needs them.
+void cce_chunk_unshare(CCE_Chunk* chunk);
+// Drops one snapshot reference.
+void cce_chunk_buffer_release(CCE_ChunkBuffer* buffer);
+
+// Gives a uniform chunk pixel storage. With `preserve` the pixels are filled with the chunk's
+// uniform colour, otherwise the caller promises to overwrite all of them. Touches only `chunk`.
+void cce_chunk_back(CCE_Layer* layer, CCE_Chunk* chunk, int preserve);
+
+// Ensures `chunk` has private pixel storage holding its current contents before a write.
+static inline void cce_chunk_materialize(CCE_Layer* layer, CCE_Chunk* chunk)
+{
+    if (chunk->shared) cce_chunk_unshare(chunk);
+    if (chunk->uniform) cce_chunk_back(layer, chunk, 1);
+}
+
+// Turns the whole chunk into a single colour; storage is kept until the chunk is uploaded.
+static inline void cce_chunk_set_uniform(CCE_Layer* layer, CCE_Chunk* chunk, CCE_Color color)
+{
+    if (chunk->uniform && cce_color_equal(chunk->fill, color)) return;
+    chunk->uniform = true;
+    chunk->fill = color;
+    cce_chunk_mark_dirty(layer, chunk, 0, 0, chunk->w - 1, chunk->h - 1);
+}
+
+// Returns the packed pixel at in-bounds screen (x, y) of a CPU layer, ready for writing, together
+// with its chunk and chunk-local coordinates; the row continues for chunk->w - *out_lx pixels.
+static inline uint32_t* cce_layer_row(CCE_Layer* layer, int x, int y, CCE_Chunk** out_chunk, int* out_lx, int* out_ly)
+{
+    CCE_Chunk* chunk = cce_layer_chunk(layer, cce_chunk_index(layer, x), cce_chunk_index(layer, y));
+    const int lx = cce_chunk_local(layer, x);
+    const int ly = cce_chunk_local(layer, y);
+    cce_chunk_materialize(layer, chunk);
+    *out_chunk = chunk;
+    *out_lx = lx;
+    *out_ly = ly;
+    return (uint32_t*)(void*)chunk->data + (size_t)ly * (size_t)chunk->w + (size_t)lx;
+}
+
+// A rect of a texture to (re)write: `w` x `h` pixels at (x, y), read from `pixels` rows
+// `stride` pixels apart, or the solid `fill` when `pixels` is NULL.
+typedef struct CCE_TextureRect
+{
+    int x, y, w, h;
+    const CCE_Color* pixels;
+    int stride;
+    CCE_Color fill;
+} CCE_TextureRect;
+
+// Writes `rects` (non-overlapping) into `texture`, leaving it bound. Pixel rects are packed into the
+// shared upload arena in one pass, then one glTexSubImage2D per rect is issued from its own offset;
+// regions are fenced, so packing never overwrites data the GPU has not consumed yet. Solid rects
+// are cleared on the GPU when ARB_clear_texture is available. Returns -1 if the arena is unavailable.
+int cce_upload_texture_rects(unsigned int texture, const CCE_TextureRect* rects, int count);
+
 void cce_render_prepare_layer(CCE_Layer* layer);
+// Height of the current 2D projection; bottom-left drawing coordinates are flipped against it.
+int cce_render_projection_height(void);
+// Submits pending batches and rotates per-frame streaming state; called on buffer swap.
+void cce_render_end_frame(void);
 
 #endif
\ No newline at end of file
@@ -26,7 +26,12 @@ SOFTWARE.
 
 #include "sprite.h"
 #include "../engine.h"
+#include "../kernel/kernel.h"
+#include "../render/render.h"
 
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
 #include <GL/gl.h>
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -97,6 +102,7 @@ void cce_texture_free(CCE_Texture* tex)
 {
     if (!tex) return;
     if (tex->id) {
+        cce_batch_flush();
         GLuint id = (GLuint)tex->id;
         glDeleteTextures(1, &id);
     }
@@ -109,6 +115,7 @@ void cce_sprite_free(CCE_Sprite* img)
 {
     if (!img || !img->data) return;
     if (img->texture_id) {
+        cce_batch_flush();
         GLuint id = (GLuint)img->texture_id;
         glDeleteTextures(1, &id);
         img->texture_id = 0;
@@ -120,6 +127,148 @@ void cce_sprite_free(CCE_Sprite* img)
     img->channels = 0;
 }
 
+// Writes the frame columns [src_x, src_x + frame_w) of every sprite row, each texel scaled to a
+// scale x scale block, into a CPU layer. The sprite's top edge lands on screen row `top`.
+// Clipping is done once; every source row is tinted and widened once and then copied into
+// the chunk rows it covers, and each chunk is marked dirty once.
+static int blit_scaled(CCE_Layer* layer, const CCE_Sprite* sprite, int src_x, int frame_w,
+                       int left, int top, int scale, uint32_t tint)
+{
+    const long long right = (long long)left + (long long)frame_w * scale - 1;
+    const long long bottom = (long long)top + (long long)sprite->height * scale - 1;
+    const int x0 = left > 0 ? left : 0;
+    const int y0 = top > 0 ? top : 0;
+    const int x1 = right < layer->scr_w - 1 ? (int)right : layer->scr_w - 1;
+    const int y1 = bottom < layer->scr_h - 1 ? (int)bottom : layer->scr_h - 1;
+    if (x0 > x1 || y0 > y1) return 0;
+
+    // Only the texels that reach the clipped columns are tinted.
+    const int t0 = (x0 - left) / scale;
+    const int t1 = (x1 - left) / scale;
+    const size_t texels = (size_t)(t1 - t0 + 1);
+    const size_t span = (size_t)(x1 - x0 + 1);
+    uint32_t* tinted = malloc((texels + span) * sizeof(uint32_t));
+    if (!tinted) {
+        ERRLOG;
+        return -1;
+    }
+    uint32_t* scaled = tinted + texels;
+    const CCE_BlendMode mode = layer->blend_mode;
+
+    int src_row = -1;
+    const int cy1 = cce_chunk_index(layer, y1);
+    const int cx0 = cce_chunk_index(layer, x0);
+    const int cx1 = cce_chunk_index(layer, x1);
+    for (int cy = cce_chunk_index(layer, y0); cy <= cy1; cy++) {
+        const int sy = cy * layer->chunk_size;
+        const int ry0 = y0 > sy ? y0 : sy;
+        const int ry1 = y1 < sy + layer->chunk_size - 1 ? y1 : sy + layer->chunk_size - 1;
+
+        for (int cx = cx0; cx <= cx1; cx++) {
+            CCE_Chunk* chunk = cce_layer_chunk(layer, cx, cy);
+            const int sx = cx * layer->chunk_size;
+            const int lx0 = x0 > sx ? x0 - sx : 0;
+            const int lx1 = x1 < sx + chunk->w - 1 ? x1 - sx : chunk->w - 1;
+            const int whole = lx0 == 0 && lx1 == chunk->w - 1 && ry0 == sy && ry1 == sy + chunk->h - 1;
+            // A REPLACE blit over the whole chunk overwrites every pixel; no need to expand a uniform fill.
+            if (whole && mode == CCE_BLEND_REPLACE) cce_chunk_back(layer, chunk, 0);
+            cce_chunk_materialize(layer, chunk);
+        }
+
+        for (int y = ry0; y <= ry1; y++) {
+            const int row = (y - top) / scale;
+            if (row != src_row) {
+                src_row = row;
+                const unsigned char* src = sprite->data + ((size_t)row * (size_t)sprite->width + (size_t)(src_x + t0)) * 4;
+                cce_kernels.modulate(tinted, (const uint32_t*)(const void*)src, texels, tint);
+                // Widen each texel to its block, cut to the clipped columns at both ends.
+                size_t out = 0;
+                for (size_t t = 0; t < texels; t++) {
+                    const long long bx0 = (long long)left + (long long)(t0 + (int)t) * scale;
+                    const long long from = bx0 > x0 ? bx0 : x0;
+                    const long long to = bx0 + scale - 1 < x1 ? bx0 + scale - 1 : x1;
+                    const size_t n = (size_t)(to - from + 1);
+                    if (n == 1) scaled[out] = tinted[t];
+                    else cce_kernels.fill(scaled + out, tinted[t], n);
+                    out += n;
+                }
+            }
+
+            for (int cx = cx0; cx <= cx1; cx++) {
+                CCE_Chunk* chunk = cce_layer_chunk(layer, cx, cy);
+                const int sx = cx * layer->chunk_size;
+                const int lx0 = x0 > sx ? x0 - sx : 0;
+                const int lx1 = x1 < sx + chunk->w - 1 ? x1 - sx : chunk->w - 1;
+                uint32_t* dst = (uint32_t*)(void*)chunk->data + (size_t)(y - sy) * (size_t)chunk->w + (size_t)lx0;
+                const uint32_t* from = scaled + (sx + lx0 - x0);
+                const size_t n = (size_t)(lx1 - lx0 + 1);
+                if (mode == CCE_BLEND_REPLACE) cce_kernels.copy(dst, from, n);
+                else cce_blend_span(mode, dst, from, n);
+            }
+        }
+
+        for (int cx = cx0; cx <= cx1; cx++) {
+            CCE_Chunk* chunk = cce_layer_chunk(layer, cx, cy);
+            const int sx = cx * layer->chunk_size;
+            const int lx0 = x0 > sx ? x0 - sx : 0;
+            const int lx1 = x1 < sx + chunk->w - 1 ? x1 - sx : chunk->w - 1;
+            cce_chunk_mark_dirty(layer, chunk, lx0, ry0 - sy, lx1, ry1 - sy);
+        }
+    }
+
+    free(tinted);
+    return 0;
+}
+
+// Frame window of a horizontal strip: columns [*offset, *offset + *width) of the sprite.
+static int sprite_frame(const CCE_Sprite* sprite, int frame_step_px, int current_step, int* offset, int* width)
+{
+    const int img_w_total = sprite->width;
+    int frame_width = img_w_total;
+    int frame_offset_x = 0;
+
+    if (frame_step_px > 0) {
+        frame_width = frame_step_px;
+        if (frame_width > img_w_total) {
+            frame_width = img_w_total;
+        }
+
+        long long step_offset = (long long)frame_step_px * (long long)current_step;
+        frame_offset_x = (int)(step_offset % img_w_total);
+
+        if (frame_offset_x + frame_width > img_w_total) {
+            frame_width = img_w_total - frame_offset_x;
+        }
+
+        if (frame_width <= 0) {
+            return -1;
+        }
+    }
+    *offset = frame_offset_x;
+    *width = frame_width;
+    return 0;
+}
+
+// Lazily uploads the sprite as a GL texture on first GPU draw.
+static unsigned int sprite_texture(const CCE_Sprite* sprite)
+{
+    // NOTE: `sprite` is const in public API, so we update the cache via a cast.
+    CCE_Sprite* mut = (CCE_Sprite*)(void*)sprite;
+    if (mut->texture_id == 0) {
+        GLuint tex = 0;
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, sprite->width, sprite->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, sprite->data);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        mut->texture_id = (unsigned int)tex;
+    }
+    return mut->texture_id;
+}
+
 int cce_draw_sprite(
     CCE_Layer* layer,
     const CCE_Sprite* sprite,
@@ -135,43 +284,19 @@ int cce_draw_sprite(
         return -1;
     }
 
+    const int img_w_total = sprite->width;
+    const int img_h = sprite->height;
+    if (img_w_total <= 0 || img_h <= 0) {
+        ERRLOG;
+        return -1;
+    }
+
+    int frame_offset_x = 0, frame_width = 0;
+    if (sprite_frame(sprite, frame_step_px, current_step, &frame_offset_x, &frame_width) < 0) return -1;
+
     // GPU backend: upload sprite as a GL texture once and draw as a quad (baked into GPU layer FBO).
     if (layer->backend == CCE_LAYER_GPU)
     {
-        // Lazily upload the sprite texture on first draw.
-        // NOTE: `sprite` is const in public API, so we update the cache via a cast.
-        CCE_Sprite* mut = (CCE_Sprite*)(void*)sprite;
-        if (mut->texture_id == 0) {
-            GLuint tex = 0;
-            glGenTextures(1, &tex);
-            glBindTexture(GL_TEXTURE_2D, tex);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, sprite->width, sprite->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, sprite->data);
-            glBindTexture(GL_TEXTURE_2D, 0);
-            mut->texture_id = (unsigned int)tex;
-        }
-
-        const int img_w_total = sprite->width;
-        const int img_h = sprite->height;
-        if (img_w_total <= 0 || img_h <= 0) return -1;
-
-        // Determine frame window (same logic as CPU path).
-        int frame_width = img_w_total;
-        int frame_offset_x = 0;
-        if (frame_step_px > 0) {
-            frame_width = frame_step_px;
-            if (frame_width > img_w_total) frame_width = img_w_total;
-            long long offset = (long long)frame_step_px * (long long)current_step;
-            frame_offset_x = (int)(offset % img_w_total);
-            if (frame_offset_x + frame_width > img_w_total) {
-                frame_width = img_w_total - frame_offset_x;
-            }
-            if (frame_width <= 0) return -1;
-        }
-
         // UVs: sprite data is loaded top-to-bottom (stbi flip=0). OpenGL expects bottom row first.
         // CPU path compensates by reading src_y = img_h - 1 - y; for GPU we flip V in UVs.
         float u0 = (float)frame_offset_x / (float)img_w_total;
@@ -182,73 +307,205 @@ int cce_draw_sprite(
         const float w = (float)frame_width * (float)batch_size;
         const float h = (float)img_h * (float)batch_size;
         CCE_Texture tmp = {0};
-        tmp.id = mut->texture_id;
+        tmp.id = sprite_texture(sprite);
         tmp.width = img_w_total;
         tmp.height = img_h;
         return cce_draw_texture_region(&tmp, (float)dst_x, (float)dst_y, w, h, u0, v0, u1, v1, modifier);
     }
 
-    const int img_w_total = sprite->width;
-    const int img_h = sprite->height;
+    // Sprite coordinates are bottom-left; rows are stored top-down, so the first row is the top edge.
+    const int top = layer->scr_h - dst_y - img_h * batch_size;
+    return blit_scaled(layer, sprite, frame_offset_x, frame_width, dst_x, top, batch_size, cce_pack_color(modifier));
+}
 
-    if (img_w_total <= 0 || img_h <= 0) {
+// Narrows [*lo, *hi] to the steps i with 0 <= a + d * i < limit.
+static void clip_axis(double a, double d, double limit, double* lo, double* hi)
+{
+    if (fabs(d) < 1e-12) {
+        if (a < 0.0 || a >= limit) {
+            *lo = 1.0;
+            *hi = 0.0;
+        }
+        return;
+    }
+    double i0 = -a / d, i1 = (limit - a) / d;
+    if (i0 > i1) { double t = i0; i0 = i1; i1 = t; }
+    if (i0 > *lo) *lo = i0;
+    if (i1 < *hi) *hi = i1;
+}
+
+// Rotated / scaled / flipped blit into a CPU layer. Every covered screen pixel is mapped back to a
+// texel: each row's span is clipped to the frame analytically, then fetched with the sample kernel
+// in 16.16 fixed point, tinted, and written into the chunk rows it crosses. (cx, cy) is the frame
+// centre in top-left screen space.
+static int blit_affine(CCE_Layer* layer, const CCE_Sprite* sprite, int src_x, int frame_w,
+                       double cx, double cy, double scale_x, double scale_y, double angle, int flip, uint32_t tint)
+{
+    const int frame_h = sprite->height;
+    const double c = cos(angle), s = sin(angle);
+
+    // Screen bounds of the rotated frame.
+    const double hw = frame_w * 0.5 * scale_x, hh = frame_h * 0.5 * scale_y;
+    const double ex = fabs(c) * hw + fabs(s) * hh;
+    const double ey = fabs(s) * hw + fabs(c) * hh;
+    const double bx0 = floor(cx - ex), bx1 = ceil(cx + ex);
+    const double by0 = floor(cy - ey), by1 = ceil(cy + ey);
+    const int x0 = bx0 > 0.0 ? (int)bx0 : 0;
+    const int y0 = by0 > 0.0 ? (int)by0 : 0;
+    const int x1 = bx1 < layer->scr_w - 1 ? (int)bx1 : layer->scr_w - 1;
+    const int y1 = by1 < layer->scr_h - 1 ? (int)by1 : layer->scr_h - 1;
+    if (x0 > x1 || y0 > y1) return 0;
+
+    // Inverse map: screen offset (dx, dy) from the centre -> texel (u, v). Rotation is counter-clockwise
+    // on screen, so in y-down space a texel offset (lx, ly) lands at (c*lx + s*ly, -s*lx + c*ly).
+    const double fu = (flip & CCE_FLIP_H) ? -1.0 : 1.0;
+    const double fv = (flip & CCE_FLIP_V) ? -1.0 : 1.0;
+    const double du_dx = fu * c / scale_x, du_dy = -fu * s / scale_x;
+    const double dv_dx = fv * s / scale_y, dv_dy = fv * c / scale_y;
+    const int64_t limit_u = (int64_t)frame_w << 16, limit_v = (int64_t)frame_h << 16;
+    const int32_t step_u = (int32_t)llround(du_dx * 65536.0);
+    const int32_t step_v = (int32_t)llround(dv_dx * 65536.0);
+
+    const int count = x1 - x0 + 1;
+    uint32_t* row = malloc((size_t)count * sizeof(uint32_t) + (size_t)layer->chunk_count_x * 4 * sizeof(int));
+    if (!row) {
         ERRLOG;
         return -1;
     }
-
-    // Determine frame window.
-    int frame_width = img_w_total;
-    int frame_offset_x = 0;
-
-    if (frame_step_px > 0) {
-        frame_width = frame_step_px;
-        if (frame_width > img_w_total) {
-            frame_width = img_w_total;
+    // Dirty bounds per chunk column for the current chunk row, chunk-local; x1 < 0 while untouched.
+    int* box = (int*)(void*)(row + count);
+    for (int i = 0; i < layer->chunk_count_x; i++) box[i * 4 + 2] = -1;
+
+    const CCE_BlendMode mode = layer->blend_mode;
+    const uint32_t* base = (const uint32_t*)(const void*)sprite->data + src_x;
+    int band = cce_chunk_index(layer, y0);
+
+    for (int y = y0; y <= y1 + 1; y++) {
+        const int cy_index = y <= y1 ? cce_chunk_index(layer, y) : -1;
+        if (cy_index != band) {
+            for (int i = 0; i < layer->chunk_count_x; i++) {
+                int* b = box + i * 4;
+                if (b[2] < 0) continue;
+                cce_chunk_mark_dirty(layer, cce_layer_chunk(layer, i, band), b[0], b[1], b[2], b[3]);
+                b[2] = -1;
+            }
+            band = cy_index;
         }
-
-        long long offset = (long long)frame_step_px * (long long)current_step;
-        frame_offset_x = (int)(offset % img_w_total);
-
-        if (frame_offset_x + frame_width > img_w_total) {
-            frame_width = img_w_total - frame_offset_x;
+        if (y > y1) break;
+
+        const double dx = x0 + 0.5 - cx, dy = y + 0.5 - cy;
+        const double u = frame_w * 0.5 + du_dx * dx + du_dy * dy;
+        const double v = frame_h * 0.5 + dv_dx * dx + dv_dy * dy;
+        double lo = 0.0, hi = count - 1;
+        clip_axis(u, du_dx, frame_w, &lo, &hi);
+        clip_axis(v, dv_dx, frame_h, &lo, &hi);
+        if (lo > hi) continue;
+
+        // The float bounds are only a guess for the fixed-point walk; trim them against it exactly.
+        const int64_t u0 = llround(u * 65536.0), v0 = llround(v * 65536.0);
+        int i0 = (int)floor(lo) - 1, i1 = (int)ceil(hi) + 1;
+        if (i0 < 0) i0 = 0;
+        if (i1 > count - 1) i1 = count - 1;
+        for (; i0 <= i1; i0++) {
+            const int64_t tu = u0 + (int64_t)i0 * step_u, tv = v0 + (int64_t)i0 * step_v;
+            if (tu >= 0 && tu < limit_u && tv >= 0 && tv < limit_v) break;
         }
-
-        if (frame_width <= 0) {
-            return -1;
+        for (; i1 >= i0; i1--) {
+            const int64_t tu = u0 + (int64_t)i1 * step_u, tv = v0 + (int64_t)i1 * step_v;
+            if (tu >= 0 && tu < limit_u && tv >= 0 && tv < limit_v) break;
+        }
+        if (i0 > i1) continue;
+
+        const size_t n = (size_t)(i1 - i0 + 1);
+        cce_kernels.sample(row, base, (size_t)sprite->width,
+                           (int32_t)(u0 + (int64_t)i0 * step_u), (int32_t)(v0 + (int64_t)i0 * step_v),
+                           step_u, step_v, n);
+        if (tint != 0xFFFFFFFFu) cce_kernels.modulate(row, row, n, tint);
+
+        const int ly = cce_chunk_local(layer, y);
+        int x = x0 + i0;
+        const int xe = x0 + i1;
+        const uint32_t* from = row;
+        while (x <= xe) {
+            const int cx_index = cce_chunk_index(layer, x);
+            CCE_Chunk* chunk = cce_layer_chunk(layer, cx_index, band);
+            const int lx0 = cce_chunk_local(layer, x);
+            const int lx1 = xe - x < chunk->w - 1 - lx0 ? lx0 + (xe - x) : chunk->w - 1;
+            int* b = box + cx_index * 4;
+            if (b[2] < 0) {
+                cce_chunk_materialize(layer, chunk);
+                b[0] = lx0; b[1] = ly; b[2] = lx1; b[3] = ly;
+            } else {
+                if (lx0 < b[0]) b[0] = lx0;
+                if (lx1 > b[2]) b[2] = lx1;
+                b[3] = ly;
+            }
+            uint32_t* dst = (uint32_t*)(void*)chunk->data + (size_t)ly * (size_t)chunk->w + (size_t)lx0;
+            const size_t span = (size_t)(lx1 - lx0 + 1);
+            if (mode == CCE_BLEND_REPLACE) cce_kernels.copy(dst, from, span);
+            else cce_blend_span(mode, dst, from, span);
+            from += span;
+            x += (int)span;
         }
     }
 
-    for (int y = 0; y < img_h; y++) {
-        int src_y = img_h - 1 - y; // bottom-left origin for png
-        for (int x = 0; x < frame_width; x++) {
-            int idx = (src_y * img_w_total + (frame_offset_x + x)) * 4;
-
-            CCE_Color color = {
-                .r = sprite->data[idx + 0],
-                .g = sprite->data[idx + 1],
-                .b = sprite->data[idx + 2],
-                .a = sprite->data[idx + 3],
-            };
-
-            // Apply multiplicative modifier per channel.
-            color.r = (pct)((color.r * modifier.r) / 255);
-            color.g = (pct)((color.g * modifier.g) / 255);
-            color.b = (pct)((color.b * modifier.b) / 255);
-            color.a = (pct)((color.a * modifier.a) / 255);
-
-            int screen_x0 = dst_x + x * batch_size;
-            int screen_x1 = screen_x0 + batch_size - 1;
-
-            // Convert bottom-left sprite coordinates to engine's top-left origin.
-            int bottom_y = dst_y + y * batch_size;
-            int screen_y0 = layer->scr_h - (bottom_y + batch_size);
-            int screen_y1 = layer->scr_h - 1 - bottom_y;
-
-            cce_set_pixel_rect(layer, screen_x0, screen_y0, screen_x1, screen_y1, color);
+    free(row);
+    return 0;
+}
+
+int cce_draw_sprite_ex(
+    CCE_Layer* layer,
+    const CCE_Sprite* sprite,
+    float center_x,
+    float center_y,
+    float scale_x,
+    float scale_y,
+    float angle,
+    int flip,
+    CCE_Color modifier,
+    int frame_step_px,
+    int current_step)
+{
+    if (!layer || !sprite || !sprite->data || !(scale_x > 0.0f) || !(scale_y > 0.0f) ||
+        sprite->width <= 0 || sprite->height <= 0 || sprite->width > 32767 || sprite->height > 32767) {
+        ERRLOG;
+        return -1;
+    }
+
+    int frame_offset_x = 0, frame_width = 0;
+    if (sprite_frame(sprite, frame_step_px, current_step, &frame_offset_x, &frame_width) < 0) return -1;
+
+    if (layer->backend == CCE_LAYER_GPU)
+    {
+        // Same quad as cce_draw_sprite, rotated about its centre, in top-left projection space.
+        const float c = cosf(angle), s = sinf(angle);
+        const float hw = (float)frame_width * 0.5f * scale_x, hh = (float)sprite->height * 0.5f * scale_y;
+        const float cx = center_x, cy = (float)cce_render_projection_height() - center_y;
+        float u0 = (float)frame_offset_x / (float)sprite->width;
+        float u1 = (float)(frame_offset_x + frame_width) / (float)sprite->width;
+        float v0 = 1.0f, v1 = 0.0f;
+        if (flip & CCE_FLIP_H) { float t = u0; u0 = u1; u1 = t; }
+        if (flip & CCE_FLIP_V) { float t = v0; v0 = v1; v1 = t; }
+
+        const float lx[4] = { -hw, hw, hw, -hw };
+        const float ly[4] = { -hh, -hh, hh, hh };
+        const float tu[4] = { u0, u1, u1, u0 };
+        const float tv[4] = { v0, v0, v1, v1 };
+        float corner[4][4];
+        for (int i = 0; i < 4; i++) {
+            corner[i][0] = cx + c * lx[i] + s * ly[i];
+            corner[i][1] = cy - s * lx[i] + c * ly[i];
+            corner[i][2] = tu[i];
+            corner[i][3] = tv[i];
         }
+        static const int order[6] = { 0, 1, 2, 2, 3, 0 };
+        float verts[24];
+        for (int i = 0; i < 6; i++) memcpy(verts + i * 4, corner[order[i]], sizeof(corner[0]));
+        return cce_draw_triangles_textured(sprite_texture(sprite), verts, 6, modifier);
     }
 
-    return 0;
+    return blit_affine(layer, sprite, frame_offset_x, frame_width, (double)center_x, (double)(layer->scr_h - center_y),
+                       scale_x, scale_y, angle, flip, cce_pack_color(modifier));
 }
 
 void cce_sprite_calc_frame_uv(const CCE_Texture* tex, int frame_width_px, int frame_index, float* u0, float* u1)
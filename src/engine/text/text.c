@@ -26,6 +26,8 @@ SOFTWARE.
 
 #include "text.h"
 #include "../engine.h"
+#include "../render/render.h"
+#include "../kernel/kernel.h"
 
 #include <cce.h>
 #include <stdarg.h>
@@ -55,10 +57,6 @@ struct TTF_Font {
     stbtt_fontinfo info;
     int info_initialized;
 
-    // Scratch buffer for glyph rasterization (avoids per-glyph malloc/free).
-    unsigned char* glyph_scratch;
-    size_t glyph_scratch_size;
-
     float* vtx_scratch;
     size_t vtx_scratch_floats;
 
@@ -70,6 +68,10 @@ struct TTF_Font {
     CCE_GlyphEntry* glyphs;
     int glyph_count;
     int glyph_cap;
+
+    // Open-addressed index over `glyphs` (entry index + 1, 0 = empty).
+    int* glyph_slots;
+    int glyph_slot_cap;
 };
 
 #endif
@@ -89,6 +91,10 @@ struct CCE_GlyphEntry {
     int iy0;    // stbtt bitmap box y0 (offset from pen/baseline)
 
     float xadvance; // advance in screen pixels at this scale (includes base scale)
+    float bearing;  // left side bearing in screen pixels, used by the CPU layout
+
+    unsigned char* coverage; // w*h coverage bitmap, rasterized once per (codepoint, scale)
+    int in_atlas;            // coverage already packed into the GPU atlas
 };
 
 static unsigned int quantize_scale_key(float scale)
@@ -105,17 +111,33 @@ static float scale_from_key(unsigned int key)
     return (float)key / 1024.0f;
 }
 
+static unsigned int glyph_hash(int codepoint, unsigned int scale_key)
+{
+    return ((unsigned int)codepoint * 0x9E3779B1u) ^ (scale_key * 0x85EBCA77u);
+}
+
 static CCE_GlyphEntry* find_glyph(TTF_Font* font, int codepoint, unsigned int scale_key)
 {
-    if (!font || !font->glyphs) return NULL;
-    for (int i = 0; i < font->glyph_count; i++) {
-        CCE_GlyphEntry* g = (CCE_GlyphEntry*)&font->glyphs[i];
+    if (!font || !font->glyph_slots) return NULL;
+    const unsigned int mask = (unsigned int)font->glyph_slot_cap - 1u;
+    for (unsigned int i = glyph_hash(codepoint, scale_key) & mask; font->glyph_slots[i] != 0; i = (i + 1u) & mask) {
+        CCE_GlyphEntry* g = &font->glyphs[font->glyph_slots[i] - 1];
         if (g->codepoint == codepoint && g->scale_key == scale_key) return g;
     }
     return NULL;
 }
 
-static CCE_GlyphEntry* push_glyph(TTF_Font* font)
+static void index_glyph(TTF_Font* font, int index)
+{
+    const CCE_GlyphEntry* g = &font->glyphs[index];
+    const unsigned int mask = (unsigned int)font->glyph_slot_cap - 1u;
+    unsigned int i = glyph_hash(g->codepoint, g->scale_key) & mask;
+    while (font->glyph_slots[i] != 0) i = (i + 1u) & mask;
+    font->glyph_slots[i] = index + 1;
+}
+
+// Entry is indexed by its codepoint and scale_key, so both must be known up front.
+static CCE_GlyphEntry* push_glyph(TTF_Font* font, int codepoint, unsigned int scale_key)
 {
     if (!font) return NULL;
     if (font->glyph_count + 1 > font->glyph_cap) {
@@ -125,8 +147,59 @@ static CCE_GlyphEntry* push_glyph(TTF_Font* font)
         font->glyphs = nb;
         font->glyph_cap = nc;
     }
-    CCE_GlyphEntry* g = &font->glyphs[font->glyph_count++];
+    // Keep the index at most half full.
+    if ((font->glyph_count + 1) * 2 > font->glyph_slot_cap) {
+        const int cap = font->glyph_slot_cap == 0 ? 256 : font->glyph_slot_cap * 2;
+        int* slots = calloc((size_t)cap, sizeof(int));
+        if (!slots) return NULL;
+        free(font->glyph_slots);
+        font->glyph_slots = slots;
+        font->glyph_slot_cap = cap;
+        for (int i = 0; i < font->glyph_count; i++) index_glyph(font, i);
+    }
+    CCE_GlyphEntry* g = &font->glyphs[font->glyph_count];
     memset(g, 0, sizeof(*g));
+    g->codepoint = codepoint;
+    g->scale_key = scale_key;
+    index_glyph(font, font->glyph_count++);
+    return g;
+}
+
+// Cached glyph for (codepoint, scale_key); metrics and coverage are rasterized on first use only.
+static CCE_GlyphEntry* get_glyph(TTF_Font* font, int codepoint, unsigned int scale_key, float actual_scale)
+{
+    CCE_GlyphEntry* g = find_glyph(font, codepoint, scale_key);
+    if (g) return g;
+
+    int ix0 = 0, iy0 = 0, ix1 = 0, iy1 = 0;
+    stbtt_GetCodepointBitmapBox(&font->info, codepoint, actual_scale, actual_scale, &ix0, &iy0, &ix1, &iy1);
+    int aw = 0, lsb = 0;
+    stbtt_GetCodepointHMetrics(&font->info, codepoint, &aw, &lsb);
+
+    unsigned char* coverage = NULL;
+    const int w = ix1 - ix0;
+    const int h = iy1 - iy0;
+    if (w > 0 && h > 0) {
+        coverage = malloc((size_t)w * (size_t)h);
+        if (!coverage) return NULL;
+        stbtt_MakeCodepointBitmap(&font->info, coverage, w, h, w, actual_scale, actual_scale, codepoint);
+    }
+
+    g = push_glyph(font, codepoint, scale_key);
+    if (!g) {
+        free(coverage);
+        return NULL;
+    }
+    // Empty glyphs (spaces etc) are cached too so we don't re-query constantly.
+    if (coverage) {
+        g->w = w;
+        g->h = h;
+        g->ix0 = ix0;
+        g->iy0 = iy0;
+        g->coverage = coverage;
+    }
+    g->xadvance = (float)aw * actual_scale;
+    g->bearing = (float)lsb * actual_scale;
     return g;
 }
 
@@ -159,48 +232,14 @@ static int ensure_glyph_atlas(TTF_Font* font)
     return 0;
 }
 
-static int upload_glyph_to_atlas(
-    TTF_Font* font,
-    int codepoint,
-    unsigned int scale_key,
-    float actual_scale)
+static int upload_glyph_to_atlas(TTF_Font* font, CCE_GlyphEntry* g)
 {
-    if (!font || !font->info_initialized) return -1;
+    if (g->in_atlas || g->w <= 0 || g->h <= 0) return 0;
     if (ensure_glyph_atlas(font) != 0) return -1;
-    if (font->glyph_scratch == NULL) {
-        font->glyph_scratch = NULL;
-        font->glyph_scratch_size = 0;
-    }
-
-    int ix0 = 0, iy0 = 0, ix1 = 0, iy1 = 0;
-    stbtt_GetCodepointBitmapBox(&font->info, codepoint, actual_scale, actual_scale, &ix0, &iy0, &ix1, &iy1);
-
-    const int w = ix1 - ix0;
-    const int h = iy1 - iy0;
-    if (w <= 0 || h <= 0) {
-        // Still cache as empty so we don't re-query constantly (spaces etc).
-        CCE_GlyphEntry* g = push_glyph(font);
-        if (!g) return -1;
-        int aw = 0, lsb = 0;
-        stbtt_GetCodepointHMetrics(&font->info, codepoint, &aw, &lsb);
-        g->codepoint = codepoint;
-        g->scale_key = scale_key;
-        g->x = 0; g->y = 0; g->w = 0; g->h = 0;
-        g->ix0 = 0; g->iy0 = 0;
-        g->xadvance = (float)aw * actual_scale;
-        return 0;
-    }
 
+    const int w = g->w;
+    const int h = g->h;
     const size_t needed = (size_t)w * (size_t)h;
-    if (needed > font->glyph_scratch_size) {
-        unsigned char* nb = realloc(font->glyph_scratch, needed);
-        if (!nb) return -1;
-        font->glyph_scratch = nb;
-        font->glyph_scratch_size = needed;
-    }
-
-    unsigned char* bitmap = font->glyph_scratch;
-    stbtt_MakeCodepointBitmap(&font->info, bitmap, w, h, w, actual_scale, actual_scale, codepoint);
 
     // Pack into atlas (simple shelf packer with 1px padding).
     const int pad = 1;
@@ -234,7 +273,7 @@ static int upload_glyph_to_atlas(
         rgba[i * 4 + 0] = 255;
         rgba[i * 4 + 1] = 255;
         rgba[i * 4 + 2] = 255;
-        rgba[i * 4 + 3] = bitmap[i];
+        rgba[i * 4 + 3] = g->coverage[i];
     }
 
     glBindTexture(GL_TEXTURE_2D, font->texture_id);
@@ -243,21 +282,9 @@ static int upload_glyph_to_atlas(
 
     if (rgba != small_rgba) free(rgba);
 
-    // Store metrics for layout.
-    int aw = 0, lsb = 0;
-    stbtt_GetCodepointHMetrics(&font->info, codepoint, &aw, &lsb);
-
-    CCE_GlyphEntry* g = push_glyph(font);
-    if (!g) return -1;
-    g->codepoint = codepoint;
-    g->scale_key = scale_key;
     g->x = gx;
     g->y = gy;
-    g->w = w;
-    g->h = h;
-    g->ix0 = ix0;
-    g->iy0 = iy0;
-    g->xadvance = (float)aw * actual_scale;
+    g->in_atlas = 1;
     return 0;
 }
 
@@ -293,14 +320,14 @@ TTF_Font* cce_font_load(const char* filename, float font_size)
     font->ttf_data = ttf_data;
     font->ttf_data_size = file_size;
 
-    font->glyph_scratch = NULL;
-    font->glyph_scratch_size = 0;
     font->vtx_scratch = NULL;
     font->vtx_scratch_floats = 0;
 
     font->glyphs = NULL;
     font->glyph_count = 0;
     font->glyph_cap = 0;
+    font->glyph_slots = NULL;
+    font->glyph_slot_cap = 0;
     font->atlas_cursor_x = 0;
     font->atlas_cursor_y = 0;
     font->atlas_row_h = 0;
@@ -313,13 +340,13 @@ TTF_Font* cce_font_load(const char* filename, float font_size)
 void cce_font_free(TTF_Font* font)
 {
     if (font) {
+        cce_batch_flush();
         glDeleteTextures(1, &font->texture_id);
         if (font->glyphs) {
+            for (int i = 0; i < font->glyph_count; i++) free(font->glyphs[i].coverage);
             free(font->glyphs);
         }
-        if (font->glyph_scratch) {
-            free(font->glyph_scratch);
-        }
+        free(font->glyph_slots);
         if (font->vtx_scratch) {
             free(font->vtx_scratch);
         }
@@ -411,6 +438,54 @@ float cce_text_height(TTF_Font* font, const char* text, float scale)
     return line_height * lines;
 }
 
+// Glyph coverage becomes source alpha, so text composites with the layer's blend mode.
+static void blend_coverage(CCE_BlendMode mode, uint32_t* dst, const unsigned char* coverage, int count, uint32_t color)
+{
+    uint32_t src[256];
+    const uint32_t rgb = color & 0x00FFFFFFu;
+    const uint32_t alpha = color >> 24;
+    for (int at = 0; at < count; at += 256) {
+        const int n = count - at < 256 ? count - at : 256;
+        for (int i = 0; i < n; i++) src[i] = rgb | ((coverage[at + i] * alpha) / 255u) << 24;
+        cce_blend_span(mode, dst + at, src, (size_t)n);
+    }
+}
+
+// Glyph box clipped to the layer, written chunk by chunk with one dirty mark per chunk.
+static void blit_glyph(CCE_Layer* layer, const CCE_GlyphEntry* g, int left, int top, uint32_t color)
+{
+    const int x0 = left > 0 ? left : 0;
+    const int y0 = top > 0 ? top : 0;
+    const int x1 = left + g->w - 1 < layer->scr_w - 1 ? left + g->w - 1 : layer->scr_w - 1;
+    const int y1 = top + g->h - 1 < layer->scr_h - 1 ? top + g->h - 1 : layer->scr_h - 1;
+    if (x0 > x1 || y0 > y1) return;
+
+    const CCE_BlendMode mode = layer->blend_mode;
+    const int cy1 = cce_chunk_index(layer, y1);
+    const int cx0 = cce_chunk_index(layer, x0);
+    const int cx1 = cce_chunk_index(layer, x1);
+    for (int cy = cce_chunk_index(layer, y0); cy <= cy1; cy++) {
+        const int sy = cy * layer->chunk_size;
+        const int ry0 = y0 > sy ? y0 : sy;
+        const int ry1 = y1 < sy + layer->chunk_size - 1 ? y1 : sy + layer->chunk_size - 1;
+        for (int cx = cx0; cx <= cx1; cx++) {
+            CCE_Chunk* chunk = cce_layer_chunk(layer, cx, cy);
+            const int sx = cx * layer->chunk_size;
+            const int lx0 = x0 > sx ? x0 - sx : 0;
+            const int lx1 = x1 < sx + chunk->w - 1 ? x1 - sx : chunk->w - 1;
+            const size_t n = (size_t)(lx1 - lx0 + 1);
+            cce_chunk_materialize(layer, chunk);
+            for (int y = ry0; y <= ry1; y++) {
+                uint32_t* dst = (uint32_t*)(void*)chunk->data + (size_t)(y - sy) * (size_t)chunk->w + (size_t)lx0;
+                const unsigned char* coverage = g->coverage + (size_t)(y - top) * (size_t)g->w + (size_t)(sx + lx0 - left);
+                if (mode == CCE_BLEND_REPLACE) cce_kernels.coverage(dst, coverage, n, color);
+                else blend_coverage(mode, dst, coverage, (int)n, color);
+            }
+            cce_chunk_mark_dirty(layer, chunk, lx0, ry0 - sy, lx1, ry1 - sy);
+        }
+    }
+}
+
 void cce_draw_text(CCE_Layer* layer, TTF_Font* font, const char* text, 
                                int x, int y, float scale, CCE_Color color)
 {
@@ -429,9 +504,11 @@ void cce_draw_text(CCE_Layer* layer, TTF_Font* font, const char* text,
         }
         return;
     }
-    
-    // Calculate the actual scale (font scale * user scale)
-    float actual_scale = font->scale * scale;
+
+    // Same quantized scale as the GPU path, so both share one glyph cache.
+    const unsigned int scale_key = quantize_scale_key(scale);
+    if (scale_key == 0) return;
+    float actual_scale = font->scale * scale_from_key(scale_key);
     
     // Get font metrics for baseline
     int ascent, descent, line_gap;
@@ -440,6 +517,7 @@ void cce_draw_text(CCE_Layer* layer, TTF_Font* font, const char* text,
     float current_x = (float)x;
     float current_y = (float)y;
     float start_x = current_x;
+    const uint32_t packed = cce_pack_color(color);
     
     while (*text) {
         if (*text == '\n') {
@@ -450,68 +528,22 @@ void cce_draw_text(CCE_Layer* layer, TTF_Font* font, const char* text,
         }
         
         int codepoint = (unsigned char)*text;
-        
-        // Get character metrics
-        int advance_width, left_side_bearing;
-        stbtt_GetCodepointHMetrics(&font->info, codepoint, &advance_width, &left_side_bearing);
-        
-        // Get bitmap box to determine size
-        int ix0, iy0, ix1, iy1;
-        stbtt_GetCodepointBitmapBox(&font->info, codepoint, actual_scale, actual_scale, &ix0, &iy0, &ix1, &iy1);
-        
-        int bitmap_width = ix1 - ix0;
-        int bitmap_height = iy1 - iy0;
-        
-        if (bitmap_width > 0 && bitmap_height > 0) {
-            const size_t needed = (size_t)bitmap_width * (size_t)bitmap_height;
-            if (needed > font->glyph_scratch_size) {
-                unsigned char* new_buf = realloc(font->glyph_scratch, needed);
-                if (!new_buf) {
-                    // Skip glyph if allocation fails.
-                    current_x += advance_width * actual_scale;
-                    text++;
-                    continue;
-                }
-                font->glyph_scratch = new_buf;
-                font->glyph_scratch_size = needed;
-            }
+        CCE_GlyphEntry* g = get_glyph(font, codepoint, scale_key, actual_scale);
+        if (!g) {
+            text++;
+            continue;
+        }
 
-            unsigned char* bitmap = font->glyph_scratch;
-            // Render glyph to bitmap
-            stbtt_MakeCodepointBitmap(&font->info, bitmap, bitmap_width, bitmap_height,
-                                      bitmap_width, actual_scale, actual_scale, codepoint);
-                
-                // Calculate position
-                // stb_truetype uses y-up coordinate system (y=0 at baseline, y increases upward)
-                // layer uses y-down coordinate system (y=0 at top, y increases downward)
-                // ix0, iy0 is top-left of bitmap in font coords (iy0 is negative, above baseline)
-                // To convert: layer_y = baseline_y + font_y (since layer y increases downward)
-                int base_x = (int)(current_x + left_side_bearing * actual_scale + ix0);
-                int base_y = (int)(current_y + iy0); // iy0 is negative, so this gives top of bitmap
-                
-                // Write pixels to layer
-                for (int by = 0; by < bitmap_height; by++) {
-                    for (int bx = 0; bx < bitmap_width; bx++) {
-                        unsigned char alpha = bitmap[by * bitmap_width + bx];
-                        if (alpha > 0) {
-                            int px = base_x + bx;
-                            int py = base_y + by;
-                            
-                            // Blend color with alpha
-                            CCE_Color pixel_color;
-                            pixel_color.r = (unsigned char)((color.r * alpha) / 255);
-                            pixel_color.g = (unsigned char)((color.g * alpha) / 255);
-                            pixel_color.b = (unsigned char)((color.b * alpha) / 255);
-                            pixel_color.a = (unsigned char)((color.a * alpha) / 255);
-                            
-                            cce_set_pixel(layer, px, py, pixel_color);
-                        }
-                    }
-                }
+        if (g->coverage) {
+            // stb_truetype uses y-up coordinates with iy0 the (negative) top of the bitmap
+            // above the baseline, so the layer's y-down top is simply baseline + iy0.
+            int base_x = (int)(current_x + g->bearing + g->ix0);
+            int base_y = (int)(current_y + g->iy0);
+            blit_glyph(layer, g, base_x, base_y, packed);
         }
         
         // Advance to next character
-        current_x += advance_width * actual_scale;
+        current_x += g->xadvance;
         text++;
     }
 }
@@ -599,19 +631,14 @@ int cce_draw_text_gpu(TTF_Font* font, const char* text, float x, float y, float
 
         const int codepoint = (int)c;
 
-        CCE_GlyphEntry* g = find_glyph(font, codepoint, scale_key);
-        if (!g) {
-            if (upload_glyph_to_atlas(font, codepoint, scale_key, actual_scale) != 0) {
-                // Skip glyph on failure but still advance.
-                int aw = 0, lsb = 0;
-                stbtt_GetCodepointHMetrics(&font->info, codepoint, &aw, &lsb);
-                int next = (unsigned char)*(p + 1);
-                int kern = stbtt_GetCodepointKernAdvance(&font->info, codepoint, next);
-                pen_x += (aw + kern) * actual_scale;
-                continue;
-            }
-            g = find_glyph(font, codepoint, scale_key);
-            if (!g) continue;
+        CCE_GlyphEntry* g = get_glyph(font, codepoint, scale_key, actual_scale);
+        if (!g) continue;
+        if (upload_glyph_to_atlas(font, g) != 0) {
+            // Skip glyph on failure but still advance.
+            int next = (unsigned char)*(p + 1);
+            int kern = stbtt_GetCodepointKernAdvance(&font->info, codepoint, next);
+            pen_x += g->xadvance + (float)kern * actual_scale;
+            continue;
         }
 
         // Advance includes kerning to next character (like cce_text_width).
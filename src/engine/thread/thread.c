@@ -0,0 +1,181 @@
+/*
+===========================================================================
+MIT License
+
+Copyright (c) 2026 Stepan Pukhovskiy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+===========================================================================
+*/
+
+#include "thread.h"
+#include "../engine.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define CCE_MAX_THREADS 64
+
+typedef struct
+{
+    void (*fn)(int index, void* userdata);
+    void* userdata;
+    int count;
+    atomic_int next;
+} CCE_ParallelJob;
+
+static pthread_mutex_t g_dispatch_lock = PTHREAD_MUTEX_INITIALIZER; // one parallel_for at a time
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t g_idle = PTHREAD_COND_INITIALIZER;
+
+static pthread_t g_workers[CCE_MAX_THREADS];
+static int g_worker_count = 0;
+static int g_started = 0;
+static int g_stop = 0;
+static unsigned g_generation = 0;
+static int g_active = 0;
+static CCE_ParallelJob* g_job = NULL;
+
+static _Thread_local int g_in_job = 0;
+
+static void run_job(CCE_ParallelJob* job)
+{
+    g_in_job = 1;
+    for (;;) {
+        const int i = atomic_fetch_add_explicit(&job->next, 1, memory_order_relaxed);
+        if (i >= job->count) break;
+        job->fn(i, job->userdata);
+    }
+    g_in_job = 0;
+}
+
+// `arg` carries the generation at pool start, so a job posted before the thread runs is not missed.
+static void* worker_main(void* arg)
+{
+    unsigned seen = (unsigned)(uintptr_t)arg;
+
+    pthread_mutex_lock(&g_lock);
+    while (!g_stop) {
+        if (g_generation == seen) {
+            pthread_cond_wait(&g_wake, &g_lock);
+            continue;
+        }
+        seen = g_generation;
+        CCE_ParallelJob* job = g_job;
+        pthread_mutex_unlock(&g_lock);
+
+        run_job(job);
+
+        pthread_mutex_lock(&g_lock);
+        if (--g_active == 0) pthread_cond_signal(&g_idle);
+    }
+    pthread_mutex_unlock(&g_lock);
+    return NULL;
+}
+
+// Called with g_dispatch_lock held.
+static void pool_start(void)
+{
+    g_started = 1;
+
+    int threads = engine_threads;
+    if (threads <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cores > 0 ? (int)cores : 1;
+    }
+    if (threads > CCE_MAX_THREADS) threads = CCE_MAX_THREADS;
+
+    g_stop = 0;
+    g_worker_count = 0;
+    for (int i = 0; i < threads - 1; i++) {
+        if (pthread_create(&g_workers[g_worker_count], NULL, worker_main, (void*)(uintptr_t)g_generation) != 0) {
+            cce_printf("⚠️ Worker thread %d failed to start\n", i);
+            break;
+        }
+        g_worker_count++;
+    }
+    cce_printf("Worker pool: %d threads\n", g_worker_count + 1);
+}
+
+void cce_parallel_for(int count, void (*fn)(int index, void* userdata), void* userdata)
+{
+    if (count <= 0 || !fn) return;
+
+    if (count == 1 || g_in_job) {
+        for (int i = 0; i < count; i++) fn(i, userdata);
+        return;
+    }
+
+    pthread_mutex_lock(&g_dispatch_lock);
+    if (!g_started) pool_start();
+
+    CCE_ParallelJob job = { .fn = fn, .userdata = userdata, .count = count };
+    atomic_init(&job.next, 0);
+
+    if (g_worker_count == 0) {
+        run_job(&job);
+        pthread_mutex_unlock(&g_dispatch_lock);
+        return;
+    }
+
+    pthread_mutex_lock(&g_lock);
+    g_job = &job;
+    g_active = g_worker_count;
+    g_generation++;
+    pthread_cond_broadcast(&g_wake);
+    pthread_mutex_unlock(&g_lock);
+
+    run_job(&job);
+
+    pthread_mutex_lock(&g_lock);
+    while (g_active > 0) pthread_cond_wait(&g_idle, &g_lock);
+    g_job = NULL;
+    pthread_mutex_unlock(&g_lock);
+
+    pthread_mutex_unlock(&g_dispatch_lock);
+}
+
+int cce_thread_count(void)
+{
+    pthread_mutex_lock(&g_dispatch_lock);
+    if (!g_started) pool_start();
+    const int n = g_worker_count + 1;
+    pthread_mutex_unlock(&g_dispatch_lock);
+    return n;
+}
+
+void cce_thread_pool_shutdown(void)
+{
+    pthread_mutex_lock(&g_dispatch_lock);
+    if (g_started) {
+        pthread_mutex_lock(&g_lock);
+        g_stop = 1;
+        pthread_cond_broadcast(&g_wake);
+        pthread_mutex_unlock(&g_lock);
+        for (int i = 0; i < g_worker_count; i++) pthread_join(g_workers[i], NULL);
+        g_worker_count = 0;
+        g_started = 0;
+    }
+    pthread_mutex_unlock(&g_dispatch_lock);
+}
@@ -26,6 +26,7 @@ SOFTWARE.
 
 #include "window.h"
 #include "../engine.h"
+#include "../render/render.h"
 #include "../../external/stb_image.h"
 
 #include <GL/gl.h>
@@ -354,7 +355,7 @@ void cce_window_poll_events(void)
 
 void cce_window_swap_buffers(Window* window)
 {
-    if (window && window->handle) { glfwSwapBuffers(window->handle); }
+    if (window && window->handle) { cce_render_end_frame(); glfwSwapBuffers(window->handle); }
 }
 
 void cce_window_make_current(Window* window)
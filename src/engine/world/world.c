@@ -0,0 +1,795 @@
+/*
+===========================================================================
+MIT License
+
+Copyright (c) 2026 Stepan Pukhovskiy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+===========================================================================
+*/
+
+#define _DEFAULT_SOURCE 1 // mkstemp/ftruncate/mmap under -std=c23
+#include "world.h"
+#include "../engine.h"
+#include "../kernel/kernel.h"
+#include "../render/render.h"
+#include "../thread/thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#define CCE_WORLD_MIN_BUCKETS 64
+#define CCE_WORLD_IDLE_FRAMES 30
+#define CCE_WORLD_PACK_BATCH 32
+#define CCE_WORLD_SPILL_MIN_SHIFT 6 // smallest spill slot: 64 bytes
+#define CCE_WORLD_SPILL_INITIAL ((size_t)16 * 1024 * 1024)
+
+// Chunk codec tuned for pixel art: a token byte holds the op in the top two bits and
+// length - 1 (up to 64 pixels) below. LIT copies the pixels that follow, RUN repeats one pixel,
+// ROW copies the pixels one row up (vertical repeats are common in tiles and dithering).
+enum { RLE_LIT = 0, RLE_RUN = 1, RLE_ROW = 2 };
+#define RLE_MAX_LEN 64
+
+static size_t rle_bound(int count)
+{
+    return (size_t)count * sizeof(uint32_t) + (size_t)(count + RLE_MAX_LEN - 1) / RLE_MAX_LEN;
+}
+
+static size_t rle_flush_literal(const uint32_t* src, int start, int end, unsigned char* dst)
+{
+    if (start >= end) return 0;
+    dst[0] = (unsigned char)((RLE_LIT << 6) | (end - start - 1));
+    memcpy(dst + 1, src + start, (size_t)(end - start) * sizeof(uint32_t));
+    return 1 + (size_t)(end - start) * sizeof(uint32_t);
+}
+
+static size_t rle_encode(const uint32_t* src, int w, int count, unsigned char* dst)
+{
+    size_t out = 0;
+    int lit = 0; // start of the pending literal
+    int i = 0;
+    while (i < count) {
+        const int max = count - i < RLE_MAX_LEN ? count - i : RLE_MAX_LEN;
+        int run = 1;
+        while (run < max && src[i + run] == src[i]) run++;
+        int row = 0;
+        if (i >= w) {
+            while (row < max && src[i + row] == src[i + row - w]) row++;
+        }
+
+        // A ROW token is one byte, so even a single matching pixel beats a literal.
+        if (row > 0 && row >= run) {
+            out += rle_flush_literal(src, lit, i, dst + out);
+            dst[out++] = (unsigned char)((RLE_ROW << 6) | (row - 1));
+            i += row;
+            lit = i;
+        } else if (run >= 2) {
+            out += rle_flush_literal(src, lit, i, dst + out);
+            dst[out++] = (unsigned char)((RLE_RUN << 6) | (run - 1));
+            memcpy(dst + out, &src[i], sizeof(uint32_t));
+            out += sizeof(uint32_t);
+            i += run;
+            lit = i;
+        } else {
+            i++;
+            if (i - lit == RLE_MAX_LEN) {
+                out += rle_flush_literal(src, lit, i, dst + out);
+                lit = i;
+            }
+        }
+    }
+    out += rle_flush_literal(src, lit, count, dst + out);
+    return out;
+}
+
+static int rle_decode(const unsigned char* src, size_t size, int w, uint32_t* dst, int count)
+{
+    size_t at = 0;
+    int i = 0;
+    while (at < size) {
+        const int op = src[at] >> 6;
+        const int len = (src[at] & (RLE_MAX_LEN - 1)) + 1;
+        at++;
+        if (i + len > count) return -1;
+
+        if (op == RLE_LIT) {
+            if (at + (size_t)len * sizeof(uint32_t) > size) return -1;
+            memcpy(dst + i, src + at, (size_t)len * sizeof(uint32_t));
+            at += (size_t)len * sizeof(uint32_t);
+        } else if (op == RLE_RUN) {
+            if (at + sizeof(uint32_t) > size) return -1;
+            uint32_t pixel;
+            memcpy(&pixel, src + at, sizeof(uint32_t));
+            at += sizeof(uint32_t);
+            cce_kernels.fill(dst + i, pixel, (size_t)len);
+        } else if (op == RLE_ROW) {
+            if (i < w) return -1;
+            for (int k = 0; k < len; k++) dst[i + k] = dst[i + k - w];
+        } else {
+            return -1;
+        }
+        i += len;
+    }
+    return i == count ? 0 : -1;
+}
+
+static void list_unlink(CCE_WorldList* list, CCE_WorldChunk* chunk)
+{
+    if (chunk->lru_prev) chunk->lru_prev->lru_next = chunk->lru_next;
+    else list->head = chunk->lru_next;
+    if (chunk->lru_next) chunk->lru_next->lru_prev = chunk->lru_prev;
+    else list->tail = chunk->lru_prev;
+    chunk->lru_prev = NULL;
+    chunk->lru_next = NULL;
+}
+
+static void list_push(CCE_WorldList* list, CCE_WorldChunk* chunk)
+{
+    chunk->lru_prev = NULL;
+    chunk->lru_next = list->head;
+    if (list->head) list->head->lru_prev = chunk;
+    else list->tail = chunk;
+    list->head = chunk;
+}
+
+static size_t world_raw_bytes(const CCE_WorldLayer* world)
+{
+    return (size_t)world->chunk_size * (size_t)world->chunk_size * sizeof(CCE_Color);
+}
+
+static int spill_open(CCE_WorldLayer* world)
+{
+    const char* dir = getenv("TMPDIR");
+    char path[512];
+    snprintf(path, sizeof(path), "%s/cce-spill-XXXXXX", dir && dir[0] ? dir : "/tmp");
+    const int fd = mkstemp(path);
+    if (fd < 0) {
+        ERRLOG;
+        return -1;
+    }
+    // Unlinked right away: the file lives exactly as long as the descriptor.
+    unlink(path);
+    world->spill_fd = fd;
+    cce_printf("World \"%s\" spills to %s\n", world->name, dir && dir[0] ? dir : "/tmp");
+    return 0;
+}
+
+// Hands out a slot of 2^(cls + CCE_WORLD_SPILL_MIN_SHIFT) bytes, recycling freed slots first.
+static int spill_alloc(CCE_WorldLayer* world, int cls, long* out_offset)
+{
+    if (world->spill_free_count[cls] > 0) {
+        *out_offset = world->spill_free[cls][--world->spill_free_count[cls]];
+        return 0;
+    }
+
+    const size_t slot = (size_t)1 << (cls + CCE_WORLD_SPILL_MIN_SHIFT);
+    if (world->spill_fd < 0 && spill_open(world) != 0) return -1;
+    if (world->spill_end + slot > world->spill_size) {
+        size_t size = world->spill_size ? world->spill_size : CCE_WORLD_SPILL_INITIAL;
+        while (size < world->spill_end + slot) size *= 2;
+        if (ftruncate(world->spill_fd, (off_t)size) != 0) {
+            ERRLOG;
+            return -1;
+        }
+        unsigned char* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, world->spill_fd, 0);
+        if (map == MAP_FAILED) {
+            ERRLOG;
+            return -1;
+        }
+        if (world->spill_map) munmap(world->spill_map, world->spill_size);
+        world->spill_map = map;
+        world->spill_size = size;
+    }
+    *out_offset = (long)world->spill_end;
+    world->spill_end += slot;
+    return 0;
+}
+
+static void spill_release(CCE_WorldLayer* world, int cls, long offset)
+{
+    if (world->spill_free_count[cls] == world->spill_free_cap[cls]) {
+        const int cap = world->spill_free_cap[cls] ? world->spill_free_cap[cls] * 2 : 16;
+        long* grown = realloc(world->spill_free[cls], (size_t)cap * sizeof(long));
+        if (!grown) return; // the slot is leaked until the next clear
+        world->spill_free[cls] = grown;
+        world->spill_free_cap[cls] = cap;
+    }
+    world->spill_free[cls][world->spill_free_count[cls]++] = offset;
+}
+
+// Frees whatever holds the chunk's pixels (raw, packed or spilled).
+static void world_drop_pixels(CCE_WorldLayer* world, CCE_WorldChunk* chunk)
+{
+    if (chunk->data) {
+        list_unlink(&world->raw_lru, chunk);
+        free(chunk->data);
+        chunk->data = NULL;
+        world->memory.raw_bytes -= world_raw_bytes(world);
+        world->memory.raw_chunks--;
+    }
+    if (chunk->packed) {
+        list_unlink(&world->packed_lru, chunk);
+        free(chunk->packed);
+        chunk->packed = NULL;
+        world->memory.packed_bytes -= (size_t)chunk->packed_size;
+        world->memory.packed_chunks--;
+    }
+    if (chunk->spilled) {
+        spill_release(world, chunk->spill_class, chunk->spill_offset);
+        chunk->spilled = false;
+        world->memory.spilled_bytes -= (size_t)chunk->packed_size;
+        world->memory.spilled_chunks--;
+    }
+}
+
+// Brings a packed or spilled chunk back to raw pixels.
+static int world_unpack(CCE_WorldLayer* world, CCE_WorldChunk* chunk)
+{
+    if (!chunk->packed && !chunk->spilled) return 0;
+
+    const int count = world->chunk_size * world->chunk_size;
+    CCE_Color* data = malloc(world_raw_bytes(world));
+    if (!data) {
+        ERRLOG;
+        return -1;
+    }
+    const unsigned char* src = chunk->spilled ? world->spill_map + chunk->spill_offset : chunk->packed;
+    if (rle_decode(src, (size_t)chunk->packed_size, world->chunk_size, (uint32_t*)(void*)data, count) != 0) {
+        ERRLOG;
+        free(data);
+        return -1;
+    }
+
+    world_drop_pixels(world, chunk);
+    chunk->data = data;
+    world->memory.raw_bytes += world_raw_bytes(world);
+    world->memory.raw_chunks++;
+    list_push(&world->raw_lru, chunk);
+    return 0;
+}
+
+// Makes the chunk's pixels directly addressable and marks it as used this frame.
+static int world_access(CCE_WorldLayer* world, CCE_WorldChunk* chunk)
+{
+    if (world_unpack(world, chunk) != 0) return -1;
+    chunk->last_used = world->frame;
+    if (chunk->data && world->raw_lru.head != chunk) {
+        list_unlink(&world->raw_lru, chunk);
+        list_push(&world->raw_lru, chunk);
+    }
+    return 0;
+}
+
+typedef struct
+{
+    CCE_WorldLayer* world;
+    CCE_WorldChunk** chunks;
+} CCE_WorldPackWork;
+
+static void world_pack_job(int index, void* userdata)
+{
+    CCE_WorldPackWork* work = userdata;
+    CCE_WorldChunk* chunk = work->chunks[index];
+    const int count = work->world->chunk_size * work->world->chunk_size;
+
+    unsigned char* buf = malloc(rle_bound(count));
+    if (!buf) return; // stays raw
+    const size_t size = rle_encode((const uint32_t*)(const void*)chunk->data, work->world->chunk_size, count, buf);
+    unsigned char* packed = realloc(buf, size);
+    chunk->packed = packed ? packed : buf;
+    chunk->packed_size = (int)size;
+}
+
+// Compresses raw chunks on the worker pool, then swaps their storage on the calling thread.
+// Returns how many were packed.
+static int world_pack(CCE_WorldLayer* world, CCE_WorldChunk** chunks, int count)
+{
+    CCE_WorldPackWork work = { world, chunks };
+    cce_parallel_for(count, world_pack_job, &work);
+
+    int packed = 0;
+    for (int i = 0; i < count; i++) {
+        CCE_WorldChunk* chunk = chunks[i];
+        if (!chunk->packed) continue;
+        list_unlink(&world->raw_lru, chunk);
+        free(chunk->data);
+        chunk->data = NULL;
+        world->memory.raw_bytes -= world_raw_bytes(world);
+        world->memory.raw_chunks--;
+        list_push(&world->packed_lru, chunk);
+        world->memory.packed_bytes += (size_t)chunk->packed_size;
+        world->memory.packed_chunks++;
+        packed++;
+    }
+    return packed;
+}
+
+static int world_spill(CCE_WorldLayer* world, CCE_WorldChunk* chunk)
+{
+    int cls = 0;
+    while (((size_t)1 << (cls + CCE_WORLD_SPILL_MIN_SHIFT)) < (size_t)chunk->packed_size) cls++;
+    if (cls >= CCE_WORLD_SPILL_CLASSES) return -1;
+
+    long offset;
+    if (spill_alloc(world, cls, &offset) != 0) return -1;
+    memcpy(world->spill_map + offset, chunk->packed, (size_t)chunk->packed_size);
+
+    list_unlink(&world->packed_lru, chunk);
+    free(chunk->packed);
+    chunk->packed = NULL;
+    world->memory.packed_bytes -= (size_t)chunk->packed_size;
+    world->memory.packed_chunks--;
+    chunk->spilled = true;
+    chunk->spill_class = cls;
+    chunk->spill_offset = offset;
+    world->memory.spilled_bytes += (size_t)chunk->packed_size;
+    world->memory.spilled_chunks++;
+    return 0;
+}
+
+static int world_over_budget(const CCE_WorldLayer* world)
+{
+    return world->budget_bytes && world->memory.raw_bytes + world->memory.packed_bytes > world->budget_bytes;
+}
+
+// Residency pass: compresses one batch of idle off-screen chunks per frame; while over budget,
+// keeps compressing the least recently used ones and then spills the oldest compressed chunks.
+static void world_trim(CCE_WorldLayer* world)
+{
+    CCE_WorldChunk* batch[CCE_WORLD_PACK_BATCH];
+    for (;;) {
+        const int over = world_over_budget(world);
+        int n = 0;
+        for (CCE_WorldChunk* chunk = world->raw_lru.tail; chunk && n < CCE_WORLD_PACK_BATCH; chunk = chunk->lru_prev) {
+            if (chunk->tile >= 0) continue;
+            const int idle = world->idle_frames > 0 && world->frame - chunk->last_used >= (unsigned long)world->idle_frames;
+            if (!idle && !over) break; // the rest were used more recently
+            batch[n++] = chunk;
+        }
+        if (n == 0 || world_pack(world, batch, n) == 0 || !over) break;
+    }
+
+    while (world_over_budget(world) && world->packed_lru.tail) {
+        if (world_spill(world, world->packed_lru.tail) != 0) break;
+    }
+}
+
+static inline uint32_t world_hash(int cx, int cy)
+{
+    return ((uint32_t)cx * 0x9E3779B1u) ^ ((uint32_t)cy * 0x85EBCA77u);
+}
+
+static void world_grow(CCE_WorldLayer* world)
+{
+    const int count = world->bucket_count * 2;
+    CCE_WorldChunk** buckets = calloc((size_t)count, sizeof(CCE_WorldChunk*));
+    if (!buckets) return; // keep the longer chains
+
+    for (int i = 0; i < world->bucket_count; i++) {
+        CCE_WorldChunk* chunk = world->buckets[i];
+        while (chunk) {
+            CCE_WorldChunk* next = chunk->next;
+            const uint32_t slot = world_hash(chunk->cx, chunk->cy) & (uint32_t)(count - 1);
+            chunk->next = buckets[slot];
+            buckets[slot] = chunk;
+            chunk = next;
+        }
+    }
+    free(world->buckets);
+    world->buckets = buckets;
+    world->bucket_count = count;
+}
+
+// Returns chunk (cx, cy), creating it transparent when `create` is set; NULL if absent.
+static CCE_WorldChunk* world_chunk(CCE_WorldLayer* world, int cx, int cy, int create)
+{
+    CCE_WorldChunk* chunk = world->last;
+    if (chunk && chunk->cx == cx && chunk->cy == cy) return chunk;
+
+    const uint32_t slot = world_hash(cx, cy) & (uint32_t)(world->bucket_count - 1);
+    for (chunk = world->buckets[slot]; chunk; chunk = chunk->next) {
+        if (chunk->cx == cx && chunk->cy == cy) {
+            world->last = chunk;
+            return chunk;
+        }
+    }
+    if (!create) return NULL;
+
+    chunk = calloc(1, sizeof(CCE_WorldChunk));
+    if (!chunk) {
+        ERRLOG;
+        return NULL;
+    }
+    chunk->cx = cx;
+    chunk->cy = cy;
+    chunk->uniform = true;
+    chunk->tile = -1;
+    chunk->next = world->buckets[slot];
+    world->buckets[slot] = chunk;
+    world->chunk_count++;
+    world->last = chunk;
+
+    if (world->chunk_count > world->bucket_count) world_grow(world);
+    return chunk;
+}
+
+static void world_mark_dirty(CCE_WorldChunk* chunk, int x0, int y0, int x1, int y1)
+{
+    if (!chunk->dirty) {
+        chunk->dirty = true;
+        chunk->dirty_x0 = x0;
+        chunk->dirty_y0 = y0;
+        chunk->dirty_x1 = x1;
+        chunk->dirty_y1 = y1;
+        return;
+    }
+    if (x0 < chunk->dirty_x0) chunk->dirty_x0 = x0;
+    if (y0 < chunk->dirty_y0) chunk->dirty_y0 = y0;
+    if (x1 > chunk->dirty_x1) chunk->dirty_x1 = x1;
+    if (y1 > chunk->dirty_y1) chunk->dirty_y1 = y1;
+}
+
+// Gives a uniform chunk its own pixels before a partial write.
+static int world_materialize(CCE_WorldLayer* world, CCE_WorldChunk* chunk)
+{
+    if (!chunk->uniform) return 0;
+    chunk->data = malloc(world_raw_bytes(world));
+    if (!chunk->data) {
+        ERRLOG;
+        return -1;
+    }
+    world->memory.raw_bytes += world_raw_bytes(world);
+    world->memory.raw_chunks++;
+    list_push(&world->raw_lru, chunk);
+    cce_kernels.fill((uint32_t*)(void*)chunk->data, cce_pack_color(chunk->fill), (size_t)world->chunk_size * (size_t)world->chunk_size);
+    chunk->uniform = false;
+    return 0;
+}
+
+static void world_set_uniform(CCE_WorldLayer* world, CCE_WorldChunk* chunk, CCE_Color color)
+{
+    if (chunk->uniform && cce_color_equal(chunk->fill, color)) return;
+    world_drop_pixels(world, chunk);
+    chunk->uniform = true;
+    chunk->fill = color;
+    world_mark_dirty(chunk, 0, 0, world->chunk_size - 1, world->chunk_size - 1);
+}
+
+CCE_WorldLayer* cce_world_create(int view_w, int view_h, char * name, int chunk_size)
+{
+    if (chunk_size == 0) chunk_size = CCE_WORLD_CHUNK_SIZE;
+    if (view_w <= 0 || view_h <= 0 || chunk_size < CCE_CHUNK_SIZE_MIN || chunk_size > CCE_CHUNK_SIZE_MAX ||
+        (chunk_size & (chunk_size - 1)) != 0) {
+        ERRLOG;
+        return NULL;
+    }
+
+    CCE_WorldLayer* world = calloc(1, sizeof(CCE_WorldLayer));
+    if (!world) return NULL;
+
+    world->enabled = true;
+    world->chunk_size = chunk_size;
+    while ((1 << world->chunk_shift) < chunk_size) world->chunk_shift++;
+    world->view_w = view_w;
+    world->view_h = view_h;
+    world->idle_frames = CCE_WORLD_IDLE_FRAMES;
+    world->spill_fd = -1;
+
+    // A viewport at any camera offset touches at most view/chunk + 2 chunks per axis.
+    world->tiles_x = view_w / chunk_size + 2;
+    world->tiles_y = view_h / chunk_size + 2;
+    const int tiles = world->tiles_x * world->tiles_y;
+
+    world->name = malloc(strlen(name ? name : "") + 1);
+    world->bucket_count = CCE_WORLD_MIN_BUCKETS;
+    world->buckets = calloc((size_t)world->bucket_count, sizeof(CCE_WorldChunk*));
+    world->tile_owner = calloc((size_t)tiles, sizeof(CCE_WorldChunk*));
+    world->free_tiles = malloc((size_t)tiles * sizeof(int));
+    world->verts = malloc((size_t)tiles * 6 * 4 * sizeof(float));
+    world->uploads = malloc((size_t)tiles * sizeof(CCE_TextureRect));
+    if (!world->name || !world->buckets || !world->tile_owner || !world->free_tiles || !world->verts || !world->uploads) {
+        ERRLOG;
+        cce_world_destroy(world);
+        return NULL;
+    }
+    strcpy(world->name, name ? name : "");
+
+    // Free list handed out from the front of the atlas first.
+    for (int i = 0; i < tiles; i++) world->free_tiles[i] = tiles - 1 - i;
+    world->free_count = tiles;
+
+    glGenTextures(1, &world->atlas);
+    glBindTexture(GL_TEXTURE_2D, world->atlas);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, world->tiles_x * chunk_size, world->tiles_y * chunk_size,
+                 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    cce_printf("New World Layer: view %dx%d, %dpx chunks, %d tiles, name \"%s\"\n",
+        view_w, view_h, chunk_size, tiles, world->name);
+    return world;
+}
+
+void cce_world_clear(CCE_WorldLayer* world)
+{
+    if (!world) return;
+    for (int i = 0; i < world->bucket_count; i++) {
+        CCE_WorldChunk* chunk = world->buckets[i];
+        while (chunk) {
+            CCE_WorldChunk* next = chunk->next;
+            free(chunk->data);
+            free(chunk->packed);
+            free(chunk);
+            chunk = next;
+        }
+        world->buckets[i] = NULL;
+    }
+    world->chunk_count = 0;
+    world->last = NULL;
+    world->raw_lru = (CCE_WorldList){ NULL, NULL };
+    world->packed_lru = (CCE_WorldList){ NULL, NULL };
+    world->memory = (CCE_WorldMemory){ 0 };
+    // The spill file is kept mapped; its slots are simply handed out again.
+    world->spill_end = 0;
+    for (int i = 0; i < CCE_WORLD_SPILL_CLASSES; i++) world->spill_free_count[i] = 0;
+
+    const int tiles = world->tiles_x * world->tiles_y;
+    for (int i = 0; i < tiles; i++) {
+        world->tile_owner[i] = NULL;
+        world->free_tiles[i] = tiles - 1 - i;
+    }
+    world->free_count = tiles;
+}
+
+void cce_world_destroy(CCE_WorldLayer* world)
+{
+    if (!world) return;
+    cce_printf("Destroying World Layer: name \"%s\"\n", world->name ? world->name : "");
+    if (world->buckets && world->tile_owner && world->free_tiles) cce_world_clear(world);
+    if (world->atlas) glDeleteTextures(1, &world->atlas);
+    if (world->spill_map) munmap(world->spill_map, world->spill_size);
+    if (world->spill_fd >= 0) close(world->spill_fd);
+    for (int i = 0; i < CCE_WORLD_SPILL_CLASSES; i++) free(world->spill_free[i]);
+    free(world->buckets);
+    free(world->tile_owner);
+    free(world->free_tiles);
+    free(world->verts);
+    free(world->uploads);
+    free(world->name);
+    free(world);
+}
+
+void cce_world_set_camera(CCE_WorldLayer* world, int world_x, int world_y)
+{
+    if (!world) return;
+    world->camera_x = world_x;
+    world->camera_y = world_y;
+}
+
+int cce_world_set_residency(CCE_WorldLayer* world, size_t budget_bytes, int idle_frames)
+{
+    if (!world || idle_frames < 0) {
+        ERRLOG;
+        return -1;
+    }
+    world->budget_bytes = budget_bytes;
+    world->idle_frames = idle_frames;
+    return 0;
+}
+
+int cce_world_get_memory(const CCE_WorldLayer* world, CCE_WorldMemory* out)
+{
+    if (!world || !out) return -1;
+    *out = world->memory;
+    return 0;
+}
+
+void cce_world_set_pixel(CCE_WorldLayer* world, int world_x, int world_y, CCE_Color color)
+{
+    if (!world) return;
+    const int cx = cce_world_floor(world_x, world->chunk_shift);
+    const int cy = cce_world_floor(world_y, world->chunk_shift);
+    const int mask = world->chunk_size - 1;
+    const int lx = world_x & mask;
+    const int ly = world_y & mask;
+
+    CCE_WorldChunk* chunk = world_chunk(world, cx, cy, 1);
+    if (!chunk || world_access(world, chunk) != 0) return;
+    if (chunk->uniform && cce_color_equal(chunk->fill, color)) return;
+    if (world_materialize(world, chunk) != 0) return;
+
+    chunk->data[(ly << world->chunk_shift) + lx] = color;
+    world_mark_dirty(chunk, lx, ly, lx, ly);
+}
+
+CCE_Color cce_world_get_pixel(CCE_WorldLayer* world, int world_x, int world_y)
+{
+    if (!world) return (CCE_Color){ 0, 0, 0, 0 };
+    CCE_WorldChunk* chunk = world_chunk(world, cce_world_floor(world_x, world->chunk_shift),
+                                        cce_world_floor(world_y, world->chunk_shift), 0);
+    if (!chunk || world_access(world, chunk) != 0) return (CCE_Color){ 0, 0, 0, 0 };
+    if (chunk->uniform) return chunk->fill;
+    const int mask = world->chunk_size - 1;
+    return chunk->data[((world_y & mask) << world->chunk_shift) + (world_x & mask)];
+}
+
+void cce_world_set_pixel_rect(CCE_WorldLayer* world, int x0, int y0, int x1, int y1, CCE_Color color)
+{
+    if (!world) return;
+    if (x0 > x1) { int t = x0; x0 = x1; x1 = t; }
+    if (y0 > y1) { int t = y0; y0 = y1; y1 = t; }
+
+    const int cs = world->chunk_size;
+    const int shift = world->chunk_shift;
+    const uint32_t packed = cce_pack_color(color);
+
+    for (int cy = cce_world_floor(y0, shift); cy <= cce_world_floor(y1, shift); cy++) {
+        for (int cx = cce_world_floor(x0, shift); cx <= cce_world_floor(x1, shift); cx++) {
+            const int sx = cx * cs, sy = cy * cs;
+            const int lx0 = x0 > sx ? x0 - sx : 0;
+            const int ly0 = y0 > sy ? y0 - sy : 0;
+            const int lx1 = x1 < sx + cs - 1 ? x1 - sx : cs - 1;
+            const int ly1 = y1 < sy + cs - 1 ? y1 - sy : cs - 1;
+
+            CCE_WorldChunk* chunk = world_chunk(world, cx, cy, 1);
+            if (!chunk) return;
+
+            if (lx0 == 0 && ly0 == 0 && lx1 == cs - 1 && ly1 == cs - 1) {
+                world_set_uniform(world, chunk, color);
+                continue;
+            }
+            if (world_access(world, chunk) != 0) return;
+            if (chunk->uniform && cce_color_equal(chunk->fill, color)) continue;
+            if (world_materialize(world, chunk) != 0) return;
+
+            const size_t span = (size_t)(lx1 - lx0 + 1);
+            for (int ly = ly0; ly <= ly1; ly++) {
+                cce_kernels.fill((uint32_t*)(void*)(chunk->data + ((size_t)ly << shift) + lx0), packed, span);
+            }
+            world_mark_dirty(chunk, lx0, ly0, lx1, ly1);
+        }
+    }
+}
+
+// Queues the dirty part of a resident chunk (or all of it) for its atlas tile. Uniform chunks
+// become solid rects, which are cleared on the GPU instead of streamed.
+static void world_queue_upload(CCE_WorldLayer* world, const CCE_WorldChunk* chunk, int full, CCE_TextureRect* rect)
+{
+    const int cs = world->chunk_size;
+    const int x0 = full || chunk->uniform ? 0 : chunk->dirty_x0;
+    const int y0 = full || chunk->uniform ? 0 : chunk->dirty_y0;
+    const int x1 = full || chunk->uniform ? cs - 1 : chunk->dirty_x1;
+    const int y1 = full || chunk->uniform ? cs - 1 : chunk->dirty_y1;
+    rect->x = (chunk->tile % world->tiles_x) * cs + x0;
+    rect->y = (chunk->tile / world->tiles_x) * cs + y0;
+    rect->w = x1 - x0 + 1;
+    rect->h = y1 - y0 + 1;
+    rect->pixels = chunk->uniform ? NULL : chunk->data + ((size_t)y0 << world->chunk_shift) + x0;
+    rect->stride = cs;
+    rect->fill = chunk->fill;
+}
+
+// Chunk that owns the atlas tile a queued rect was written for.
+static CCE_WorldChunk* world_rect_owner(const CCE_WorldLayer* world, const CCE_TextureRect* rect)
+{
+    const int tile = (rect->y / world->chunk_size) * world->tiles_x + rect->x / world->chunk_size;
+    return world->tile_owner[tile];
+}
+
+void render_world(CCE_WorldLayer* world)
+{
+    if (!world || !world->enabled) return;
+    world->frame++;
+
+    const int cs = world->chunk_size;
+    const int shift = world->chunk_shift;
+    const int cx0 = cce_world_floor(world->camera_x, shift);
+    const int cy0 = cce_world_floor(world->camera_y, shift);
+    const int cx1 = cce_world_floor(world->camera_x + world->view_w - 1, shift);
+    const int cy1 = cce_world_floor(world->camera_y + world->view_h - 1, shift);
+
+    // Tiles whose chunk scrolled out of view go back to the pool.
+    const int tiles = world->tiles_x * world->tiles_y;
+    for (int t = 0; t < tiles; t++) {
+        CCE_WorldChunk* owner = world->tile_owner[t];
+        if (!owner || (owner->cx >= cx0 && owner->cx <= cx1 && owner->cy >= cy0 && owner->cy <= cy1)) continue;
+        owner->tile = -1;
+        world->tile_owner[t] = NULL;
+        world->free_tiles[world->free_count++] = t;
+    }
+
+    // Tiles assigned this frame are filled from the back of the scratch arrays, so they can be
+    // handed back and left undrawn if the upload fails.
+    const float inv_w = 1.0f / (float)(world->tiles_x * cs);
+    const float inv_h = 1.0f / (float)(world->tiles_y * cs);
+    int quads = 0, fresh_quads = 0;
+    int uploads = 0, fresh_uploads = 0;
+
+    for (int cy = cy0; cy <= cy1; cy++) {
+        for (int cx = cx0; cx <= cx1; cx++) {
+            CCE_WorldChunk* chunk = world_chunk(world, cx, cy, 0);
+            if (!chunk || world_access(world, chunk) != 0) continue;
+
+            int fresh = 0;
+            if (chunk->tile < 0) {
+                if (world->free_count == 0) continue;
+                chunk->tile = world->free_tiles[--world->free_count];
+                world->tile_owner[chunk->tile] = chunk;
+                world_queue_upload(world, chunk, 1, &world->uploads[tiles - ++fresh_uploads]);
+                fresh = 1;
+            } else if (chunk->dirty) {
+                world_queue_upload(world, chunk, 0, &world->uploads[uploads++]);
+            }
+
+            // Fully transparent chunks keep their tile but cost no quad.
+            if (chunk->uniform && chunk->fill.a == 0) continue;
+
+            float* v = fresh ? world->verts + (size_t)(tiles - ++fresh_quads) * 24 : world->verts + (size_t)quads++ * 24;
+
+            const float x0 = (float)(cx * cs - world->camera_x), x1 = x0 + (float)cs;
+            const float y0 = (float)(cy * cs - world->camera_y), y1 = y0 + (float)cs;
+            const float u0 = (float)((chunk->tile % world->tiles_x) * cs) * inv_w, u1 = u0 + (float)cs * inv_w;
+            const float v0 = (float)((chunk->tile / world->tiles_x) * cs) * inv_h, v1 = v0 + (float)cs * inv_h;
+            *v++ = x0; *v++ = y0; *v++ = u0; *v++ = v0;
+            *v++ = x1; *v++ = y0; *v++ = u1; *v++ = v0;
+            *v++ = x1; *v++ = y1; *v++ = u1; *v++ = v1;
+
+            *v++ = x1; *v++ = y1; *v++ = u1; *v++ = v1;
+            *v++ = x0; *v++ = y1; *v++ = u0; *v++ = v1;
+            *v++ = x0; *v++ = y0; *v++ = u0; *v++ = v0;
+        }
+    }
+
+    // Every tile of the frame goes through the upload arena at once. Pending quads may still
+    // sample tiles that are about to be overwritten, so they are drawn first.
+    if (uploads + fresh_uploads > 0) {
+        memmove(world->uploads + uploads, world->uploads + (tiles - fresh_uploads), (size_t)fresh_uploads * sizeof(CCE_TextureRect));
+        cce_batch_flush();
+        if (cce_upload_texture_rects(world->atlas, world->uploads, uploads + fresh_uploads) == 0) {
+            for (int i = 0; i < uploads + fresh_uploads; i++) world_rect_owner(world, &world->uploads[i])->dirty = false;
+        } else {
+            // Dirty chunks stay dirty and retry next frame; new tiles go back to the pool undrawn.
+            for (int i = uploads; i < uploads + fresh_uploads; i++) {
+                CCE_WorldChunk* chunk = world_rect_owner(world, &world->uploads[i]);
+                world->tile_owner[chunk->tile] = NULL;
+                world->free_tiles[world->free_count++] = chunk->tile;
+                chunk->tile = -1;
+            }
+            fresh_quads = 0;
+        }
+    }
+    if (fresh_quads > 0) {
+        memmove(world->verts + (size_t)quads * 24, world->verts + (size_t)(tiles - fresh_quads) * 24, (size_t)fresh_quads * 24 * sizeof(float));
+        quads += fresh_quads;
+    }
+
+    if (quads > 0) {
+        (void)cce_draw_triangles_textured(world->atlas, world->verts, quads * 6, (CCE_Color){ 255, 255, 255, 255 });
+    }
+
+    world_trim(world);
+}